@@ -0,0 +1,296 @@
+#include "BlockCompressor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+// number of blocks encoded by a single task
+const uint32_t TASK_BLOCKS = 1024;
+
+// texels with less alpha are transparent in BC1 blocks
+const uint32_t ALPHA_THRESHOLD = 128;
+
+inline uint32_t channel(uint32_t texel, uint32_t shift)
+{
+    return texel >> shift & 0xff;
+}
+
+inline uint16_t pack565(uint32_t r, uint32_t g, uint32_t b)
+{
+    return static_cast<uint16_t>((r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+}
+
+// expands an endpoint like the decoder does, by replicating the upper bits
+inline void unpack565(uint16_t c, uint32_t* rgb)
+{
+    uint32_t r = c >> 11 & 31;
+    uint32_t g = c >> 5 & 63;
+    uint32_t b = c & 31;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+}
+
+inline void write16(uint8_t* dst, uint16_t value)
+{
+    dst[0] = value & 0xff;
+    dst[1] = value >> 8;
+}
+
+// Encodes the color part of a block. In punch-through mode, transparent
+// texels use the fourth index of the three color mode, otherwise the block
+// uses four colors.
+void encodeColor(const uint32_t* texels, bool punchThrough, uint8_t* dst)
+{
+    uint32_t lo[3] = {255, 255, 255};
+    uint32_t hi[3] = {0, 0, 0};
+    bool transparent[16];
+    bool any = false;
+
+    for (uint32_t i = 0; i < 16; i++) {
+        transparent[i] =
+            punchThrough && channel(texels[i], 24) < ALPHA_THRESHOLD;
+        if (transparent[i]) {
+            continue;
+        }
+
+        any = true;
+        for (uint32_t c = 0; c < 3; c++) {
+            uint32_t value = channel(texels[i], c * 8);
+            lo[c] = std::min(lo[c], value);
+            hi[c] = std::max(hi[c], value);
+        }
+    }
+
+    // fully transparent block
+    if (!any) {
+        write16(dst, 0);
+        write16(dst + 2, 0);
+        std::memset(dst + 4, 0xff, 4);
+        return;
+    }
+
+    // move the endpoints inwards, the interpolated colors cover the box
+    // better then
+    for (uint32_t c = 0; c < 3; c++) {
+        uint32_t inset = (hi[c] - lo[c]) >> 4;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    uint16_t c0 = pack565(hi[0], hi[1], hi[2]);
+    uint16_t c1 = pack565(lo[0], lo[1], lo[2]);
+
+    // the order of the endpoints selects the mode, c0 > c1 for four colors
+    if (punchThrough ? c0 > c1 : c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    uint32_t palette[4][3];
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+
+    uint32_t colors;
+    if (punchThrough) {
+        for (uint32_t c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        }
+        colors = 3;
+    } else if (c0 == c1) {
+        // would be decoded in three color mode, so only use the first one
+        colors = 1;
+    } else {
+        for (uint32_t c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        colors = 4;
+    }
+
+    uint32_t indices = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t best = 3;
+        if (!transparent[i]) {
+            uint32_t bestDistance = UINT32_MAX;
+            for (uint32_t p = 0; p < colors; p++) {
+                uint32_t distance = 0;
+                for (uint32_t c = 0; c < 3; c++) {
+                    int32_t d =
+                        static_cast<int32_t>(channel(texels[i], c * 8)) -
+                        static_cast<int32_t>(palette[p][c]);
+                    distance += d * d;
+                }
+
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+        }
+        indices |= best << (i * 2);
+    }
+
+    write16(dst, c0);
+    write16(dst + 2, c1);
+    std::memcpy(dst + 4, &indices, 4);
+}
+
+// encodes the alpha part of a BC3 block in the eight value mode
+void encodeAlpha(const uint32_t* texels, uint8_t* dst)
+{
+    uint32_t lo = 255;
+    uint32_t hi = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t alpha = channel(texels[i], 24);
+        lo = std::min(lo, alpha);
+        hi = std::max(hi, alpha);
+    }
+
+    dst[0] = static_cast<uint8_t>(hi);
+    dst[1] = static_cast<uint8_t>(lo);
+
+    uint64_t indices = 0;
+    if (hi > lo) {
+        // values between the endpoints are in steps of 1/7, index 0 is hi,
+        // 1 is lo and 2-7 go from hi to lo
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t alpha = channel(texels[i], 24);
+            uint32_t step = ((hi - alpha) * 7 + (hi - lo) / 2) / (hi - lo);
+            uint64_t index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+            indices |= index << (i * 3);
+        }
+    }
+
+    for (uint32_t i = 0; i < 6; i++) {
+        dst[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+inline uint32_t blockSize(TextureFormat format)
+{
+    return format == TEXTURE_BC1 ? 8 : 16;
+}
+
+// chains always go down to 1x1, like the ones of MipmapBuilder
+inline uint32_t levelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+// BC1 blocks only switch to the three color mode if they need the
+// transparent index, so opaque blocks keep all four colors
+bool hasTransparency(const uint32_t* texels)
+{
+    for (uint32_t i = 0; i < 16; i++) {
+        if (channel(texels[i], 24) < ALPHA_THRESHOLD) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+BlockCompressor::BlockCompressor(ThreadPool& pool)
+    : m_pool(pool)
+{
+}
+
+TextureFormat BlockCompressor::selectFormat(
+    const uint32_t* texels, size_t count)
+{
+    // BC1 can only represent fully opaque or fully transparent texels
+    for (size_t i = 0; i < count; i++) {
+        uint32_t alpha = channel(texels[i], 24);
+        if (alpha != 0 && alpha != 255) {
+            return TEXTURE_BC3;
+        }
+    }
+
+    return TEXTURE_BC1;
+}
+
+size_t BlockCompressor::chainSize(
+    uint32_t width, uint32_t height, TextureFormat format)
+{
+    size_t size = 0;
+    for (uint32_t level = 0; level < levelCount(width, height); level++) {
+        uint32_t blocksX = (std::max(1u, width >> level) + 3) / 4;
+        uint32_t blocksY = (std::max(1u, height >> level) + 3) / 4;
+        size += blocksX * blocksY * blockSize(format);
+    }
+    return size;
+}
+
+void BlockCompressor::compress(const uint8_t* chain, uint32_t width,
+    uint32_t height, TextureFormat format, uint8_t* dst)
+{
+    // a range of blocks in a single level
+    struct Range
+    {
+        const uint32_t* src;
+        uint8_t* dst;
+        uint32_t width;
+        uint32_t height;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    std::vector<Range> ranges;
+    uint32_t levels = levelCount(width, height);
+    for (uint32_t level = 0; level < levels; level++) {
+        uint32_t levelWidth = std::max(1u, width >> level);
+        uint32_t levelHeight = std::max(1u, height >> level);
+        uint32_t blocks = ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4);
+
+        auto src = reinterpret_cast<const uint32_t*>(chain);
+        for (uint32_t first = 0; first < blocks; first += TASK_BLOCKS) {
+            uint32_t count = std::min(TASK_BLOCKS, blocks - first);
+            ranges.push_back(
+                {src, dst, levelWidth, levelHeight, first, count});
+        }
+
+        chain += levelWidth * levelHeight * 4;
+        dst += blocks * blockSize(format);
+    }
+
+    m_pool.run(static_cast<uint32_t>(ranges.size()), [&](uint32_t i) {
+        const Range& range = ranges[i];
+        uint32_t blocksX = (range.width + 3) / 4;
+
+        for (uint32_t b = range.first; b < range.first + range.count; b++) {
+            uint32_t bx = (b % blocksX) * 4;
+            uint32_t by = (b / blocksX) * 4;
+
+            // levels smaller than a block repeat their edge texels
+            uint32_t texels[16];
+            for (uint32_t y = 0; y < 4; y++) {
+                uint32_t sy = std::min(by + y, range.height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t sx = std::min(bx + x, range.width - 1);
+                    texels[y * 4 + x] = range.src[sy * range.width + sx];
+                }
+            }
+
+            uint8_t* block = range.dst + b * blockSize(format);
+            if (format == TEXTURE_BC1) {
+                encodeColor(texels, hasTransparency(texels), block);
+            } else {
+                encodeAlpha(texels, block);
+                encodeColor(texels, false, block + 8);
+            }
+        }
+    });
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
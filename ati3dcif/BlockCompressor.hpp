@@ -0,0 +1,32 @@
+#pragma once
+
+#include "TextureFormat.hpp"
+
+#include <glrage_util/ThreadPool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace glrage {
+namespace cif {
+
+// Encodes RGBA8 mipmap chains to BC1 or BC3. Endpoints are taken from the
+// inset bounding box of each block, which trades some quality for an encoder
+// that is fast enough to run while textures are registered. Block rows are
+// distributed over a thread pool.
+class BlockCompressor
+{
+public:
+    BlockCompressor(ThreadPool& pool);
+    static TextureFormat selectFormat(const uint32_t* texels, size_t count);
+    static size_t chainSize(
+        uint32_t width, uint32_t height, TextureFormat format);
+    void compress(const uint8_t* chain, uint32_t width, uint32_t height,
+        TextureFormat format, uint8_t* dst);
+
+private:
+    ThreadPool& m_pool;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
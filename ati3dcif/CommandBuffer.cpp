@@ -0,0 +1,84 @@
+#include "CommandBuffer.hpp"
+
+#include <tuple>
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+auto stateKey(const DrawState& s)
+{
+    // all members that end up in GL state
+    return std::make_tuple(s.texture, s.minFilter, s.magFilter, s.mode,
+        s.blendSrc, s.blendDst, s.depthTest, s.depthMask, s.depthFunc);
+}
+
+} // namespace
+
+bool DrawState::operator==(const DrawState& other) const
+{
+    return stateKey(*this) == stateKey(other);
+}
+
+bool DrawState::operator!=(const DrawState& other) const
+{
+    return !(*this == other);
+}
+
+void CommandBuffer::add(const DrawState& state, uint32_t first, uint32_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // extend the previous command if possible
+    if (!m_commands.empty()) {
+        auto& last = m_commands.back();
+        if (last.state == state && last.first + last.count == first) {
+            last.count += count;
+            return;
+        }
+    }
+
+    m_commands.push_back(DrawCommand{state, first, count});
+}
+
+void CommandBuffer::merge()
+{
+    // merge neighboring commands with equal states and adjacent index ranges
+    if (m_commands.empty()) {
+        return;
+    }
+
+    size_t dst = 0;
+    for (size_t src = 1; src < m_commands.size(); src++) {
+        auto& last = m_commands[dst];
+        auto& cmd = m_commands[src];
+        if (last.state == cmd.state && last.first + last.count == cmd.first) {
+            last.count += cmd.count;
+        } else {
+            m_commands[++dst] = cmd;
+        }
+    }
+
+    m_commands.resize(dst + 1);
+}
+
+void CommandBuffer::clear()
+{
+    m_commands.clear();
+}
+
+bool CommandBuffer::empty()
+{
+    return m_commands.empty();
+}
+
+std::vector<DrawCommand>& CommandBuffer::commands()
+{
+    return m_commands;
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
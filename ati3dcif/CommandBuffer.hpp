@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ati3dcif.hpp"
+
+#include <glrage_gl/gl_core_3_3.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace glrage {
+namespace cif {
+
+// GL state of a draw call as resolved from the render states, shading
+// parameters and texture layers are selected per vertex from the material
+// table
+struct DrawState
+{
+    GLenum mode;
+    GLuint texture;
+    GLint minFilter;
+    GLint magFilter;
+    GLenum blendSrc;
+    GLenum blendDst;
+    bool depthTest;
+    GLboolean depthMask;
+    GLenum depthFunc;
+
+    bool operator==(const DrawState& other) const;
+    bool operator!=(const DrawState& other) const;
+};
+
+struct DrawCommand
+{
+    DrawState state;
+    uint32_t first;
+    uint32_t count;
+};
+
+// Records the draw calls of a frame, so they can be merged before they are
+// submitted. Draws are never reordered, as fragments at equal depth, like
+// coplanar geometry and decals, are decided by the order of the draws.
+class CommandBuffer
+{
+public:
+    void add(const DrawState& state, uint32_t first, uint32_t count);
+    void merge();
+    void clear();
+    bool empty();
+    std::vector<DrawCommand>& commands();
+
+private:
+    std::vector<DrawCommand> m_commands;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
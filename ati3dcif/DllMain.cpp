@@ -1,6 +1,6 @@
 #include "ati3dcif.hpp"
 #include "Error.hpp"
-#include "Renderer.hpp"
+#include "ThreadedRenderer.hpp"
 #include "Utils.hpp"
 
 #include <glrage/GLRage.hpp>
@@ -14,7 +14,7 @@ namespace glrage {
 namespace cif {
 
 static Context& context = GLRage::getContext();
-static std::unique_ptr<Renderer> renderer;
+static std::unique_ptr<ThreadedRenderer> renderer;
 static bool contextCreated = false;
 
 C3D_EC
@@ -45,6 +45,10 @@ return_type WINAPI function_name parameters
 
 extern "C" {
 
+// GLRage extension, copies the counters of the last finished frame
+typedef C3D_EC(WINAPI* GLRAGE_GetFrameStats_t)(FrameStats* pStats);
+C3D_EC WINAPI GLRAGE_GetFrameStats(FrameStats* pStats);
+
 EXPORT(ATI3DCIF_Init, C3D_EC, (void))
 {
     LOG_TRACE("");
@@ -52,6 +56,9 @@ EXPORT(ATI3DCIF_Init, C3D_EC, (void))
     context.init();
     context.attach();
 
+    // share the GL state shadow with the other modules
+    gl::StateCache::setCurrent(GLRage::getGLState());
+
     ErrorUtils::setHWnd(context.getHWnd());
 
     // do some cleanup in case the app forgets to call ATI3DCIF_Term
@@ -60,9 +67,12 @@ EXPORT(ATI3DCIF_Init, C3D_EC, (void))
         ATI3DCIF_Term();
     }
 
+    context.startRenderThread();
+
     try {
-        renderer = std::make_unique<Renderer>();
+        renderer = std::make_unique<ThreadedRenderer>();
     } catch (...) {
+        context.stopRenderThread();
         return HandleException();
     }
 
@@ -74,8 +84,12 @@ EXPORT(ATI3DCIF_Term, C3D_EC, (void))
     LOG_TRACE("");
 
     try {
+        // release the GL objects while the context still exists, then stop
+        // the render thread, which can't be joined anymore once the process
+        // is terminated
         if (renderer) {
-            renderer.release();
+            renderer.reset();
+            context.stopRenderThread();
         }
     } catch (...) {
         return HandleException();
@@ -317,10 +331,36 @@ EXPORT(
 EXPORT(ATI3DCIF_RenderPrimMesh, C3D_EC,
     (C3D_PVARRAY vMesh, C3D_PUINT32 pu32Indicies, C3D_UINT32 u32NumIndicies))
 {
-    LOG_TRACE("0x%p, %d", vMesh, u32NumIndicies);
+    LOG_TRACE("0x%p, 0x%p, %d", vMesh, pu32Indicies, u32NumIndicies);
 
-    // TODO
-    return C3D_EC_NOTIMPYET;
+    try {
+        renderer->renderPrimMesh(vMesh, pu32Indicies, u32NumIndicies);
+    } catch (...) {
+        return HandleException();
+    }
+
+    return C3D_EC_OK;
+}
+
+EXPORT(GLRAGE_GetFrameStats, C3D_EC, (FrameStats* pStats))
+{
+    LOG_TRACE("0x%p", pStats);
+
+    if (!pStats) {
+        return C3D_EC_BADPARAM;
+    }
+
+    if (!renderer) {
+        return C3D_EC_GENFAIL;
+    }
+
+    try {
+        *pStats = renderer->stats();
+    } catch (...) {
+        return HandleException();
+    }
+
+    return C3D_EC_OK;
 }
 
 } // extern "C"
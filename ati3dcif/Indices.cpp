@@ -0,0 +1,51 @@
+#include "Indices.hpp"
+
+#include <emmintrin.h>
+
+namespace glrage {
+namespace cif {
+
+void rebaseIndices(
+    const uint32_t* src, size_t count, uint32_t base, uint32_t* dst)
+{
+    size_t i = 0;
+
+    // rebase four indices at once
+    __m128i baseVec = _mm_set1_epi32(base);
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + i), _mm_add_epi32(v, baseVec));
+    }
+
+    for (; i < count; i++) {
+        dst[i] = src[i] + base;
+    }
+}
+
+void narrowIndices(const uint32_t* src, size_t count, uint16_t* dst)
+{
+    size_t i = 0;
+
+    // SSE2 can only pack with signed saturation, so shift the indices into the
+    // signed range first and back again after packing
+    __m128i bias32 = _mm_set1_epi32(0x8000);
+    __m128i bias16 = _mm_set1_epi16(-0x8000);
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i hi =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+        lo = _mm_sub_epi32(lo, bias32);
+        hi = _mm_sub_epi32(hi, bias32);
+        __m128i packed = _mm_add_epi16(_mm_packs_epi32(lo, hi), bias16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+
+    for (; i < count; i++) {
+        dst[i] = static_cast<uint16_t>(src[i]);
+    }
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace glrage {
+namespace cif {
+
+// copies indices with base added to each of them, which places a cached index
+// list behind the vertices that are already in the batch
+void rebaseIndices(
+    const uint32_t* src, size_t count, uint32_t base, uint32_t* dst);
+
+// copies indices that are known to fit into 16 bits
+void narrowIndices(const uint32_t* src, size_t count, uint16_t* dst);
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
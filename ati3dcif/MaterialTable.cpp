@@ -0,0 +1,65 @@
+#include "MaterialTable.hpp"
+
+#include <cstring>
+
+namespace glrage {
+namespace cif {
+
+MaterialTable::MaterialTable()
+    : m_buffer(GL_UNIFORM_BUFFER)
+{
+    m_materials.reserve(MAX_MATERIALS);
+}
+
+uint32_t MaterialTable::add(const Material& material)
+{
+    // Materials only change a few times per frame and the table is small, so a
+    // linear search is sufficient. Recently added materials are the most
+    // likely ones to be used again.
+    for (size_t i = m_materials.size(); i > 0; i--) {
+        if (memcmp(&m_materials[i - 1], &material, sizeof(Material)) == 0) {
+            return static_cast<uint32_t>(i - 1);
+        }
+    }
+
+    if (m_materials.size() >= MAX_MATERIALS) {
+        return INVALID_INDEX;
+    }
+
+    m_materials.push_back(material);
+    return static_cast<uint32_t>(m_materials.size() - 1);
+}
+
+GLsizeiptr MaterialTable::upload()
+{
+    if (m_materials.empty()) {
+        return 0;
+    }
+
+    // the shader always sees the full table, so orphan the whole storage and
+    // then fill in the used entries
+    m_buffer.bind();
+    m_buffer.data(sizeof(Material) * MAX_MATERIALS, nullptr, GL_STREAM_DRAW);
+    GLsizeiptr size = sizeof(Material) * m_materials.size();
+    m_buffer.subData(0, size, &m_materials[0]);
+
+    return size;
+}
+
+void MaterialTable::bind(GLuint binding)
+{
+    m_buffer.bindBase(binding);
+}
+
+void MaterialTable::clear()
+{
+    m_materials.clear();
+}
+
+uint32_t MaterialTable::size()
+{
+    return static_cast<uint32_t>(m_materials.size());
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
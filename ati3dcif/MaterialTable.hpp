@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ati3dcif.hpp"
+
+#include <glrage_gl/Buffer.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace glrage {
+namespace cif {
+
+// shading parameters of a draw call, laid out like the Material struct of the
+// std140 uniform block in the shaders
+struct Material
+{
+    float solidColor[4];
+    float chromaKey[4];
+    int32_t shadeMode;
+    int32_t tmapEnable;
+    int32_t tmapLight;
+    int32_t texOp;
+    int32_t tmapLayer;
+    int32_t tmapPalette; // palette texture row + 1, zero for RGBA textures
+    int32_t tmapLinear;
+    int32_t tmapMaxLevel;
+};
+
+static_assert(sizeof(Material) == 64, "Material size must match std140");
+
+// Collects the distinct materials used by the recorded draw calls, so they can
+// be selected per vertex instead of being set as uniforms between draws.
+class MaterialTable
+{
+public:
+    static const uint32_t MAX_MATERIALS = 256;
+    static const uint32_t INVALID_INDEX = 0xffffffff;
+
+    MaterialTable();
+    uint32_t add(const Material& material);
+    GLsizeiptr upload();
+    void bind(GLuint binding);
+    void clear();
+    uint32_t size();
+
+private:
+    gl::Buffer m_buffer;
+    std::vector<Material> m_materials;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
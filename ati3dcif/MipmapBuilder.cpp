@@ -0,0 +1,240 @@
+#include "MipmapBuilder.hpp"
+#include "Error.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <emmintrin.h>
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+// number of texels converted or filtered by a single task
+const uint32_t TASK_TEXELS = 16384;
+
+// expands a normalized component of the given number of bits to 8 bits,
+// rounded like the GL does
+inline uint32_t expand(uint32_t value, uint32_t max)
+{
+    return (value * 255 + max / 2) / max;
+}
+
+inline uint32_t rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return r | g << 8 | b << 16 | a << 24;
+}
+
+// converts a number of texels of the application format to RGBA8, the bit
+// layouts match the formats Texture::load uploads them with
+void convert(C3D_ETEXFMT format, const Palette& palette, const void* data,
+    size_t count, uint32_t* dst)
+{
+    switch (format) {
+        case C3D_ETF_RGB1555: {
+            // the alpha bit has the opposite meaning in OpenGL
+            auto src = static_cast<const uint16_t*>(data);
+            for (size_t i = 0; i < count; i++) {
+                uint32_t p = src[i];
+                dst[i] = rgba(expand(p >> 10 & 31, 31), expand(p >> 5 & 31, 31),
+                    expand(p & 31, 31), p & 0x8000 ? 0 : 0xff);
+            }
+            break;
+        }
+
+        case C3D_ETF_RGB565: {
+            auto src = static_cast<const uint16_t*>(data);
+            for (size_t i = 0; i < count; i++) {
+                uint32_t p = src[i];
+                dst[i] = rgba(expand(p & 31, 31), expand(p >> 5 & 63, 63),
+                    expand(p >> 11, 31), 0xff);
+            }
+            break;
+        }
+
+        case C3D_ETF_RGB4444: {
+            auto src = static_cast<const uint16_t*>(data);
+            for (size_t i = 0; i < count; i++) {
+                uint32_t p = src[i];
+                dst[i] = rgba((p >> 8 & 15) * 17, (p >> 4 & 15) * 17,
+                    (p & 15) * 17, (p >> 12) * 17);
+            }
+            break;
+        }
+
+        case C3D_ETF_RGB332: {
+            auto src = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < count; i++) {
+                uint32_t p = src[i];
+                dst[i] = rgba(expand(p >> 5, 7), expand(p >> 2 & 7, 7),
+                    (p & 3) * 85, 0xff);
+            }
+            break;
+        }
+
+        case C3D_ETF_CI8: {
+            palette.expand(static_cast<const uint8_t*>(data), count, dst);
+            break;
+        }
+
+        default:
+            throw Error("Unsupported texture format: " +
+                            std::string(C3D_ETEXFMT_NAMES[format]),
+                C3D_EC_NOTIMPYET);
+    }
+}
+
+uint32_t texelSize(C3D_ETEXFMT format)
+{
+    return format == C3D_ETF_RGB332 || format == C3D_ETF_CI8 ? 1 : 2;
+}
+
+// Averages 2x2 blocks of the source rows into one destination row. Two
+// destination texels are produced per iteration with 16 bit sums, the
+// remainder and odd sized levels are filtered one texel at a time.
+void downsampleRow(const uint32_t* rowA, const uint32_t* rowB,
+    uint32_t srcWidth, uint32_t* dst, uint32_t dstWidth)
+{
+    uint32_t x = 0;
+
+    if (srcWidth >= 4) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(2);
+
+        for (; x + 2 <= dstWidth; x += 2) {
+            __m128i a = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(rowA + x * 2));
+            __m128i b = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(rowB + x * 2));
+
+            // vertical sums of texels 0/1 and 2/3
+            __m128i lo = _mm_add_epi16(
+                _mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(
+                _mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+            // horizontal sums of neighboring texels
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+            __m128i sum = _mm_unpacklo_epi64(lo, hi);
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x),
+                _mm_packus_epi16(sum, sum));
+        }
+    }
+
+    for (; x < dstWidth; x++) {
+        uint32_t x0 = x * 2;
+        uint32_t x1 = std::min(x0 + 1, srcWidth - 1);
+        uint32_t texels[] = {rowA[x0], rowA[x1], rowB[x0], rowB[x1]};
+
+        uint32_t result = 0;
+        for (uint32_t shift = 0; shift < 32; shift += 8) {
+            uint32_t sum = 2;
+            for (uint32_t texel : texels) {
+                sum += texel >> shift & 0xff;
+            }
+            result |= (sum >> 2) << shift;
+        }
+        dst[x] = result;
+    }
+}
+
+} // namespace
+
+MipmapBuilder::MipmapBuilder(ThreadPool& pool)
+    : m_pool(pool)
+{
+}
+
+uint32_t MipmapBuilder::levels(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+size_t MipmapBuilder::chainSize(uint32_t width, uint32_t height)
+{
+    size_t size = 0;
+    for (uint32_t level = 0; level < levels(width, height); level++) {
+        size += std::max(1u, width >> level) * std::max(1u, height >> level);
+    }
+    return size * 4;
+}
+
+void MipmapBuilder::build(C3D_PTMAP tmap, const Palette& palette, uint8_t* dst)
+{
+    uint32_t width = 1 << tmap->u32MaxMapXSizeLg2;
+    uint32_t height = 1 << tmap->u32MaxMapYSizeLg2;
+    uint32_t numLevels = levels(width, height);
+    uint32_t appLevels = tmap->bMipMap ? numLevels : 1;
+    uint32_t texel = texelSize(tmap->eTexFormat);
+
+    // start of each level in the destination chain
+    std::vector<uint32_t*> levelData(numLevels);
+    for (uint32_t level = 0; level < numLevels; level++) {
+        levelData[level] = reinterpret_cast<uint32_t*>(dst);
+        dst += std::max(1u, width >> level) * std::max(1u, height >> level) * 4;
+    }
+
+    // convert all levels provided by the application at once, each task
+    // converts a range of texels of a single level
+    struct Range
+    {
+        uint32_t level;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    std::vector<Range> ranges;
+    for (uint32_t level = 0; level < appLevels; level++) {
+        uint32_t size =
+            std::max(1u, width >> level) * std::max(1u, height >> level);
+        for (uint32_t first = 0; first < size; first += TASK_TEXELS) {
+            uint32_t count = std::min<uint32_t>(TASK_TEXELS, size - first);
+            ranges.push_back({level, first, count});
+        }
+    }
+
+    m_pool.run(static_cast<uint32_t>(ranges.size()), [&](uint32_t i) {
+        const Range& range = ranges[i];
+        auto src = static_cast<const uint8_t*>(tmap->apvLevels[range.level]);
+        convert(tmap->eTexFormat, palette, src + range.first * texel,
+            range.count, levelData[range.level] + range.first);
+    });
+
+    // generate the remaining levels from the previous one, rows of a level
+    // are filtered in parallel
+    for (uint32_t level = appLevels; level < numLevels; level++) {
+        uint32_t srcWidth = std::max(1u, width >> (level - 1));
+        uint32_t srcHeight = std::max(1u, height >> (level - 1));
+        uint32_t dstWidth = std::max(1u, width >> level);
+        uint32_t dstHeight = std::max(1u, height >> level);
+        uint32_t taskRows = std::max<uint32_t>(1, TASK_TEXELS / dstWidth);
+        uint32_t tasks = (dstHeight + taskRows - 1) / taskRows;
+
+        const uint32_t* src = levelData[level - 1];
+        uint32_t* dstLevel = levelData[level];
+
+        m_pool.run(tasks, [&](uint32_t task) {
+            uint32_t first = task * taskRows;
+            uint32_t last = std::min(first + taskRows, dstHeight);
+            for (uint32_t y = first; y < last; y++) {
+                uint32_t y0 = y * 2;
+                uint32_t y1 = std::min(y0 + 1, srcHeight - 1);
+                downsampleRow(src + y0 * srcWidth, src + y1 * srcWidth,
+                    srcWidth, dstLevel + y * dstWidth, dstWidth);
+            }
+        });
+    }
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Palette.hpp"
+#include "ati3dcif.hpp"
+
+#include <glrage_util/ThreadPool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace glrage {
+namespace cif {
+
+// Converts the levels of a texture map to RGBA8 on the CPU and completes the
+// mipmap chain with a box filter if the application doesn't provide one. Rows
+// of each level are distributed over a thread pool.
+class MipmapBuilder
+{
+public:
+    MipmapBuilder(ThreadPool& pool);
+    static uint32_t levels(uint32_t width, uint32_t height);
+    static size_t chainSize(uint32_t width, uint32_t height);
+    void build(C3D_PTMAP tmap, const Palette& palette, uint8_t* dst);
+
+private:
+    ThreadPool& m_pool;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
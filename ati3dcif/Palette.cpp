@@ -0,0 +1,107 @@
+#include "Palette.hpp"
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace glrage {
+namespace cif {
+
+void expandScalar(
+    const uint32_t* table, const uint8_t* src, size_t count, uint32_t* dst)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = table[src[i]];
+    }
+}
+
+// looks up eight texels at once, the remainder is resolved one at a time
+TARGET_AVX2 void expandAVX2(
+    const uint32_t* table, const uint8_t* src, size_t count, uint32_t* dst)
+{
+    auto base = reinterpret_cast<const int*>(table);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i indices =
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        __m256i texels =
+            _mm256_i32gather_epi32(base, _mm256_cvtepu8_epi32(indices), 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), texels);
+    }
+
+    expandScalar(table, src + i, count - i, dst + i);
+}
+
+bool hasAVX2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // the OS must save the YMM registers on context switches as well
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    // checks the OS support of the YMM registers as well
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+namespace {
+
+typedef void (*ExpandFunc)(
+    const uint32_t* table, const uint8_t* src, size_t count, uint32_t* dst);
+
+const ExpandFunc EXPAND_FUNC = hasAVX2() ? expandAVX2 : expandScalar;
+
+} // namespace
+
+Palette::Palette()
+{
+    // unknown palettes resolve to opaque black
+    m_table.fill(0xff000000);
+}
+
+Palette::Palette(const C3D_PALETTENTRY* entries)
+{
+    update(0, SIZE, entries);
+}
+
+const std::array<uint32_t, Palette::SIZE>& Palette::table() const
+{
+    return m_table;
+}
+
+void Palette::update(
+    uint32_t first, uint32_t count, const C3D_PALETTENTRY* entries)
+{
+    // the flags of the entries are ignored, all colors are opaque
+    for (uint32_t i = 0; i < count; i++) {
+        const C3D_PALETTENTRY& c = entries[i];
+        m_table[first + i] = c.r | c.g << 8 | c.b << 16 | 0xff000000;
+    }
+}
+
+void Palette::expand(const uint8_t* src, size_t count, uint32_t* dst) const
+{
+    EXPAND_FUNC(&m_table[0], src, count, dst);
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ati3dcif.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace glrage {
+namespace cif {
+
+// Palette of CI8 textures, resolved to RGBA8 once when it's created, so
+// indices can be expanded with a single table lookup per texel.
+class Palette
+{
+public:
+    static const uint32_t SIZE = 256;
+
+    Palette();
+    Palette(const C3D_PALETTENTRY* entries);
+    const std::array<uint32_t, SIZE>& table() const;
+    void update(
+        uint32_t first, uint32_t count, const C3D_PALETTENTRY* entries);
+    void expand(const uint8_t* src, size_t count, uint32_t* dst) const;
+
+private:
+    std::array<uint32_t, SIZE> m_table;
+};
+
+// table lookup kernels, Palette::expand uses the AVX2 one if hasAVX2() is true
+void expandScalar(
+    const uint32_t* table, const uint8_t* src, size_t count, uint32_t* dst);
+void expandAVX2(
+    const uint32_t* table, const uint8_t* src, size_t count, uint32_t* dst);
+bool hasAVX2();
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
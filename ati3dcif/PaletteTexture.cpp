@@ -0,0 +1,60 @@
+#include "PaletteTexture.hpp"
+#include "Error.hpp"
+
+#include <glrage_gl/StateCache.hpp>
+#include <glrage_gl/Utils.hpp>
+
+namespace glrage {
+namespace cif {
+
+PaletteTexture::PaletteTexture(GLuint unit)
+    : gl::Texture(GL_TEXTURE_2D)
+    , m_unit(unit)
+{
+    // hand out the lowest rows first
+    m_freeRows.resize(MAX_PALETTES);
+    for (uint32_t i = 0; i < MAX_PALETTES; i++) {
+        m_freeRows[i] = MAX_PALETTES - i - 1;
+    }
+
+    // entries are only read with texelFetch, so filtering doesn't matter
+    bindUnit();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, Palette::SIZE, MAX_PALETTES, 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    gl::Utils::checkError(__FUNCTION__);
+}
+
+void PaletteTexture::bindUnit()
+{
+    gl::StateCache::current().bindTexture(m_unit, GL_TEXTURE_2D, id());
+}
+
+uint32_t PaletteTexture::allocate()
+{
+    if (m_freeRows.empty()) {
+        throw Error("No free palette texture row", C3D_EC_MEMALLOCFAIL);
+    }
+
+    uint32_t row = m_freeRows.back();
+    m_freeRows.pop_back();
+    return row;
+}
+
+void PaletteTexture::release(uint32_t row)
+{
+    m_freeRows.push_back(row);
+}
+
+void PaletteTexture::update(uint32_t row, const Palette& palette)
+{
+    bindUnit();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, Palette::SIZE, 1, GL_RGBA,
+        GL_UNSIGNED_BYTE, &palette.table()[0]);
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
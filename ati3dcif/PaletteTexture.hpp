@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Palette.hpp"
+
+#include <glrage_gl/Texture.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace glrage {
+namespace cif {
+
+// Stores the resolved palettes of indexed textures, one palette per row, so
+// they can be looked up in the fragment shader and animated by updating a
+// single row.
+class PaletteTexture : public gl::Texture
+{
+public:
+    static const uint32_t MAX_PALETTES = 256;
+
+    PaletteTexture(GLuint unit);
+    void bindUnit();
+    uint32_t allocate();
+    void release(uint32_t row);
+    void update(uint32_t row, const Palette& palette);
+
+private:
+    GLuint m_unit;
+    std::vector<uint32_t> m_freeRows;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -3,49 +3,61 @@
 #include "Utils.hpp"
 
 #include <glrage_gl/Utils.hpp>
+#include <glrage_util/Logger.hpp>
+#include <glrage_util/StringUtils.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 #include <glm/mat4x4.hpp>
 
+#include <cstring>
+
 namespace glrage {
 namespace cif {
 
-using std::placeholders::_1;
+namespace {
 
-Renderer::Renderer()
+// checks if any of the RGBA8 texels has the RGB value of the given color
+bool containsColor(const uint32_t* texels, size_t count, C3D_COLOR color)
 {
-    // register state observers
-    // clang-format off
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_VERTEX_TYPE);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_PRIM_TYPE);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_SOLID_CLR);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_SHADE_MODE);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_TMAP_EN);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_TMAP_SELECT);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_TMAP_LIGHT);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_TMAP_FILTER);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_TMAP_TEXOP);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_ALPHA_SRC);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_ALPHA_DST);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_Z_CMP_FNC);
-    m_state.registerObserver(std::bind(&Renderer::switchState, this, _1), C3D_ERS_Z_MODE);
-
-    m_state.registerObserver(std::bind(&Renderer::vertexType, this, _1), C3D_ERS_VERTEX_TYPE);
-    m_state.registerObserver(std::bind(&Renderer::primType, this, _1), C3D_ERS_PRIM_TYPE);
-    m_state.registerObserver(std::bind(&Renderer::solidColor, this, _1), C3D_ERS_SOLID_CLR);
-    m_state.registerObserver(std::bind(&Renderer::shadeMode, this, _1), C3D_ERS_SHADE_MODE);
-    m_state.registerObserver(std::bind(&Renderer::tmapEnable, this, _1), C3D_ERS_TMAP_EN);
-    m_state.registerObserver(std::bind(&Renderer::tmapSelect, this, _1), C3D_ERS_TMAP_SELECT);
-    m_state.registerObserver(std::bind(&Renderer::tmapLight, this, _1), C3D_ERS_TMAP_LIGHT);
-    m_state.registerObserver(std::bind(&Renderer::tmapFilter, this, _1), C3D_ERS_TMAP_FILTER);
-    m_state.registerObserver(std::bind(&Renderer::tmapTexOp, this, _1), C3D_ERS_TMAP_TEXOP);
-    m_state.registerObserver(std::bind(&Renderer::alphaSrc, this, _1), C3D_ERS_ALPHA_SRC);
-    m_state.registerObserver(std::bind(&Renderer::alphaDst, this, _1), C3D_ERS_ALPHA_DST);
-    m_state.registerObserver(std::bind(&Renderer::zCmpFunc, this, _1), C3D_ERS_Z_CMP_FNC);
-    m_state.registerObserver(std::bind(&Renderer::zMode, this, _1), C3D_ERS_Z_MODE);
-    // clang-format on
+    uint32_t rgb = color.r | color.g << 8 | color.b << 16;
+    for (size_t i = 0; i < count; i++) {
+        if ((texels[i] & 0xffffff) == rgb) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// Handlers of the render states, indexed by C3D_ERSID. Draw states are only
+// invalidated and resolved on the next primitive submission, so writes that
+// don't change the effective GL state don't split draw calls. States without a
+// handler are stored, but have no effect.
+const std::array<Renderer::StateHandler, C3D_ERS_NUM>
+    Renderer::STATE_HANDLERS = Renderer::stateHandlers();
+
+std::array<Renderer::StateHandler, C3D_ERS_NUM> Renderer::stateHandlers()
+{
+    // handlers are assigned by ID, so the table can't get out of order
+    std::array<StateHandler, C3D_ERS_NUM> handlers{};
+    handlers[C3D_ERS_VERTEX_TYPE] = &Renderer::vertexType;
+    handlers[C3D_ERS_PRIM_TYPE] = &Renderer::primType;
+    handlers[C3D_ERS_TMAP_SELECT] = &Renderer::tmapSelect;
+
+    const C3D_ERSID drawStates[] = {C3D_ERS_SOLID_CLR, C3D_ERS_SHADE_MODE,
+        C3D_ERS_TMAP_EN, C3D_ERS_TMAP_LIGHT, C3D_ERS_TMAP_FILTER,
+        C3D_ERS_TMAP_TEXOP, C3D_ERS_ALPHA_SRC, C3D_ERS_ALPHA_DST,
+        C3D_ERS_Z_CMP_FNC, C3D_ERS_Z_MODE};
+    for (auto id : drawStates) {
+        handlers[id] = &Renderer::invalidateState;
+    }
 
+    return handlers;
+}
+
+Renderer::Renderer()
+{
     // bind sampler
     m_sampler.bind(0);
 
@@ -63,18 +75,82 @@ Renderer::Renderer()
                          .fromFile(basePath + L"\\shaders\\ati3dcif.fsh"));
     m_program.link();
     m_program.fragmentData("fragColor");
+    m_program.uniformBlockBinding("Materials", 0);
     m_program.bind();
+    m_program.uniform1i("palettes", PALETTE_UNIT);
+
+    // resolve uniforms once
+    m_matProjection = m_program.uniform<glm::mat4>("matProjection");
+    m_matModelView = m_program.uniform<glm::mat4>("matModelView");
 
     // negate Z axis so the model is rendered behind the viewport, which is
     // better
     // than having a negative zNear in the ortho matrix, which seems to mess up
     // depth testing
     auto modelView = glm::scale(glm::mat4(), glm::vec3(1, 1, -1));
-    m_program.uniformMatrix4fv(
-        "matModelView", 1, GL_FALSE, glm::value_ptr(modelView));
+    m_matModelView.set(modelView);
 
     // cache frequently used config values
     m_wireframe = m_config.getBool("ati3dcif.wireframe", false);
+    m_shareTextures = m_config.getBool("ati3dcif.share_textures", true);
+
+    // textures are uploaded in the background with a limited number of bytes
+    // per frame
+    uint32_t uploadBudget = m_config.getInt("ati3dcif.upload_budget", 4096);
+    m_uploader = std::make_unique<TextureUploader>(uploadBudget << 10);
+
+    // optionally convert textures and generate their mipmaps on worker
+    // threads, which allows caching the results on disk
+    if (m_config.getBool("ati3dcif.cpu_mipmaps", false)) {
+        uint32_t threads = m_config.getInt("ati3dcif.mipmap_threads", 0);
+        m_threadPool = std::make_unique<ThreadPool>(threads);
+        m_mipmapBuilder = std::make_unique<MipmapBuilder>(*m_threadPool);
+
+        std::string cacheFile =
+            m_config.getString("ati3dcif.texture_cache_file", "");
+        if (!cacheFile.empty()) {
+            uint32_t cacheSize =
+                m_config.getInt("ati3dcif.texture_cache_size", 256);
+
+            // the file is mapped with 32 bit offsets
+            if (cacheSize > 4095) {
+                cacheSize = 4095;
+            }
+
+            m_diskCache = std::make_unique<TextureDiskCache>(
+                basePath + L"\\" + StringUtils::utf8ToWide(cacheFile),
+                cacheSize << 20);
+            if (!m_diskCache->valid()) {
+                m_diskCache.reset();
+            }
+        }
+
+        // compressed textures take up a quarter to an eighth of the memory
+        if (m_config.getBool("ati3dcif.compress_textures", false)) {
+            ogl_CheckExtensions();
+            if (ogl_ext_EXT_texture_compression_s3tc) {
+                m_blockCompressor =
+                    std::make_unique<BlockCompressor>(*m_threadPool);
+            } else {
+                LOG_INFO("S3TC texture compression is not supported");
+            }
+        }
+    }
+
+    // optionally keep CI8 textures as indices and look up their palettes in
+    // the shader, so palettes can be animated cheaply
+    if (m_config.getBool("ati3dcif.gpu_palettes", false)) {
+        m_paletteTexture = std::make_unique<PaletteTexture>(PALETTE_UNIT);
+    }
+
+    // optionally write frame statistics to a CSV file
+    std::string statsFile = m_config.getString("ati3dcif.stats_file", "");
+    if (!statsFile.empty()) {
+        uint32_t statsInterval =
+            m_config.getInt("ati3dcif.stats_interval", 60);
+        m_stats.open(basePath + L"\\" + StringUtils::utf8ToWide(statsFile),
+            statsInterval);
+    }
 
     // apply default state
     resetState();
@@ -84,28 +160,30 @@ Renderer::Renderer()
 
 void Renderer::renderBegin(C3D_HRC hRC)
 {
-    glEnable(GL_BLEND);
-
-    // set wireframe mode if set
-    if (m_wireframe) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    }
+    // bindings that are still current are filtered by the state cache
+    m_glState.enable(GL_BLEND, true);
+    m_glState.polygonMode(m_wireframe ? GL_LINE : GL_FILL);
 
     // bind objects
     m_program.bind();
     m_vertexStream.bind();
     m_sampler.bind(0);
+    m_materials.bind(0);
 
-    // restore texture binding
-    tmapRestore();
+    if (m_paletteTexture) {
+        m_paletteTexture->bindUnit();
+    }
 
     // CIF always uses an orthographic view, the application deals with the
     // perspective when required
     auto width = static_cast<float>(m_context.getDisplayWidth());
     auto height = static_cast<float>(m_context.getDisplayHeight());
     auto projection = glm::ortho<float>(0, width, height, 0, -1e6, 1e6);
-    m_program.uniformMatrix4fv(
-        "matProjection", 1, GL_FALSE, glm::value_ptr(projection));
+    if (m_matProjection.set(projection)) {
+        m_stats.frame().uniformUpdates++;
+    } else {
+        m_stats.frame().uniformSkips++;
+    }
 
     gl::Utils::checkError(__FUNCTION__);
 }
@@ -113,38 +191,160 @@ void Renderer::renderBegin(C3D_HRC hRC)
 void Renderer::renderEnd()
 {
     // make sure everything has been rendered
-    m_vertexStream.renderPending();
-
-    // restore polygon mode
-    if (m_wireframe) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    }
+    flush(FLUSH_FRAME_END);
+
+    FrameStats& stats = m_stats.frame();
+    stats.textureBytesUploaded += m_uploader->process();
+    stats.frameTime = m_context.getFrameTime();
+    stats.waitTime = m_context.getFrameWaitTime();
+    stats.textureBytesShared = m_textureBytesShared;
+
+    // the vertex stream counts in total, the frame gets the difference
+    auto delta = [](uint32_t total, uint32_t& last) {
+        uint32_t count = total - last;
+        last = total;
+        return count;
+    };
+    stats.streamWraps = delta(m_vertexStream.wrapCount(), m_streamWraps);
+    stats.streamWaits = delta(m_vertexStream.waitCount(), m_streamWaits);
+    stats.listRefs = delta(m_vertexStream.listVertexCount(), m_listRefs);
+    stats.listCopies = delta(m_vertexStream.listVertexCopies(), m_listCopies);
+
+    m_stats.endFrame();
+
+    // start a new stream buffer segment for the next frame
+    m_vertexStream.fence();
 
     gl::Utils::checkError(__FUNCTION__);
 }
 
-void Renderer::textureReg(C3D_PTMAP ptmapToReg, C3D_PHTX phtmap)
+void Renderer::textureReg(C3D_PTMAP ptmapToReg, C3D_HTX htx)
 {
     // LOG_TRACE("fmt=%d, xlg2=%d, ylg2=%d, mip=%d",
     //    ptmapToReg->eTexFormat, ptmapToReg->u32MaxMapXSizeLg2,
     //    ptmapToReg->u32MaxMapYSizeLg2, ptmapToReg->bMipMap);
 
-    auto texture = std::make_shared<Texture>();
-    texture->bind();
-    texture->load(ptmapToReg, m_palettes[ptmapToReg->htxpalTexPalette]);
+    // only CI8 textures use their palette, the handle of others is undefined
+    static const Palette noPalette;
+    C3D_HTXPAL htxpal = ptmapToReg->htxpalTexPalette;
+    auto it = m_palettes.end();
+    if (ptmapToReg->eTexFormat == C3D_ETF_CI8) {
+        it = m_palettes.find(htxpal);
+        if (it == m_palettes.end()) {
+            throw Error("Invalid palette handle", C3D_EC_BADPARAM);
+        }
+    }
+
+    const Palette& palette = it != m_palettes.end() ? it->second : noPalette;
+    bool indexed = m_paletteTexture && ptmapToReg->eTexFormat == C3D_ETF_CI8;
+    m_stats.frame().textureRegs++;
+
+    // reuse a registered texture with the same content, the handle stays
+    // unique so unregistering works as usual
+    uint64_t key = 0;
+    std::shared_ptr<Texture> texture;
+    if (m_shareTextures || m_mipmapBuilder) {
+        key = TextureCache::key(ptmapToReg, indexed ? nullptr : &palette);
+    }
+
+    if (m_shareTextures && key != 0) {
+        texture = m_textureCache.find(key);
+    }
 
-    // use id as texture handle
-    *phtmap = reinterpret_cast<C3D_HTX>(texture->id());
+    if (texture) {
+        m_stats.frame().textureHits++;
+        m_textureBytesShared += texture->array()->layerSize();
+    } else {
+        // indices can't be filtered, so they're always loaded as they are
+        if (m_mipmapBuilder && !indexed && key != 0) {
+            texture = buildTexture(ptmapToReg, palette, key);
+        } else {
+            // find a free layer in a texture array of the same kind
+            auto array =
+                m_texturePool.acquire(1 << ptmapToReg->u32MaxMapXSizeLg2,
+                    1 << ptmapToReg->u32MaxMapYSizeLg2,
+                    ptmapToReg->bMipMap != 0,
+                    indexed ? TEXTURE_INDEX8 : TEXTURE_RGBA8);
+
+            texture = std::make_shared<Texture>(array);
+            texture->load(ptmapToReg, palette, *m_uploader);
+        }
+
+        // the texture is finished before it's used for the first time
+        m_stats.frame().textureBytesUploaded += m_uploader->queue(texture);
+
+        if (m_shareTextures && key != 0) {
+            m_textureCache.insert(key, texture);
+        }
+    }
 
     // store in texture map
-    m_textures[*phtmap] = texture;
+    m_textures[htx] = texture;
 
-    // restore previously bound texture
-    tmapRestore();
+    // remember which textures use a palette, so its row isn't reused while
+    // they're registered
+    if (indexed) {
+        m_paletteTextures[htxpal].insert(htx);
+    }
 
     gl::Utils::checkError(__FUNCTION__);
 }
 
+std::shared_ptr<Texture> Renderer::buildTexture(
+    C3D_PTMAP tmap, const Palette& palette, uint64_t key)
+{
+    uint32_t width = 1 << tmap->u32MaxMapXSizeLg2;
+    uint32_t height = 1 << tmap->u32MaxMapYSizeLg2;
+    size_t size = MipmapBuilder::chainSize(width, height);
+
+    // the chain of a previous session can be uploaded directly
+    const uint8_t* chain = nullptr;
+    if (m_diskCache) {
+        chain = m_diskCache->find(key, size);
+    }
+
+    if (chain) {
+        m_stats.frame().textureDiskHits++;
+    } else {
+        if (m_scratch.size() < size) {
+            m_scratch.resize(size);
+        }
+
+        m_mipmapBuilder->build(tmap, palette, &m_scratch[0]);
+        chain = &m_scratch[0];
+
+        if (m_diskCache) {
+            m_diskCache->insert(key, chain, size);
+        }
+    }
+
+    // compression would alter the texels that match the chroma key, so
+    // these textures are left as they are
+    TextureFormat format = TEXTURE_RGBA8;
+    auto texels = reinterpret_cast<const uint32_t*>(chain);
+    if (m_blockCompressor &&
+        !containsColor(texels, width * height, tmap->clrTexChromaKey)) {
+        format = BlockCompressor::selectFormat(texels, width * height);
+
+        size_t compressedSize =
+            BlockCompressor::chainSize(width, height, format);
+        if (m_compressed.size() < compressedSize) {
+            m_compressed.resize(compressedSize);
+        }
+
+        m_blockCompressor->compress(
+            chain, width, height, format, &m_compressed[0]);
+        chain = &m_compressed[0];
+    }
+
+    // the chain is complete, so the texture can share arrays with textures
+    // that have application mipmaps
+    auto array = m_texturePool.acquire(width, height, true, format);
+    auto texture = std::make_shared<Texture>(array);
+    texture->loadChain(tmap, chain, *m_uploader);
+    return texture;
+}
+
 void Renderer::textureUnreg(C3D_HTX htxToUnreg)
 {
     // LOG_TRACE("id=%d", id);
@@ -154,17 +354,40 @@ void Renderer::textureUnreg(C3D_HTX htxToUnreg)
         throw Error("Invalid texture handle", C3D_EC_BADPARAM);
     }
 
+    // recorded draw calls may still use the texture
+    flush(FLUSH_TEXTURE_UNREG);
+
     // unbind texture if currently bound
     if (htxToUnreg == m_state.get(C3D_ERS_TMAP_SELECT).htx) {
         m_state.set(C3D_ERS_TMAP_SELECT, StateVar::Value{0});
+        stateChanged(C3D_ERS_TMAP_SELECT);
     }
 
     std::shared_ptr<Texture> texture = it->second;
     m_textures.erase(htxToUnreg);
+
+    // other handles still share the texture
+    if (texture.use_count() > 1) {
+        m_textureBytesShared -= texture->array()->layerSize();
+    }
+
+    if (texture->array()->indexed()) {
+        C3D_HTXPAL htxpal = texture->palette();
+        auto& dependents = m_paletteTextures[htxpal];
+        dependents.erase(htxToUnreg);
+        if (dependents.empty()) {
+            m_paletteTextures.erase(htxpal);
+
+            // the palette may have been destroyed before its last texture
+            if (m_palettes.find(htxpal) == m_palettes.end()) {
+                releasePaletteRow(htxpal);
+            }
+        }
+    }
 }
 
 void Renderer::texturePaletteCreate(
-    C3D_ECI_TMAP_TYPE epalette, void* pPalette, C3D_PHTXPAL phtpalCreated)
+    C3D_ECI_TMAP_TYPE epalette, void* pPalette, C3D_HTXPAL htxpal)
 {
     if (epalette != C3D_ECI_TMAP_8BIT) {
         throw Error("Unsupported palette type: " +
@@ -172,170 +395,420 @@ void Renderer::texturePaletteCreate(
             C3D_EC_NOTIMPYET);
     }
 
-    // copy palette entries to vector
-    auto palettePtr = static_cast<C3D_PPALETTENTRY>(pPalette);
-    std::vector<C3D_PALETTENTRY> palette(palettePtr, palettePtr + 256);
-
-    // create new palette handle
-    auto handle = reinterpret_cast<C3D_HTXPAL>(m_paletteID++);
-
-    // store palette
-    m_palettes[handle] = palette;
+    // resolve palette entries to RGBA once, textures using it are expanded
+    // with a plain table lookup
+    Palette palette(static_cast<C3D_PPALETTENTRY>(pPalette));
+    m_palettes[htxpal] = palette;
 
-    *phtpalCreated = handle;
+    if (m_paletteTexture) {
+        uint32_t row = m_paletteTexture->allocate();
+        m_paletteTexture->update(row, palette);
+        m_paletteRows[htxpal] = row;
+    }
 }
 
 void Renderer::texturePaletteDestroy(C3D_HTXPAL htxpalToDestroy)
 {
     m_palettes.erase(htxpalToDestroy);
+
+    if (m_paletteTextures.find(htxpalToDestroy) == m_paletteTextures.end()) {
+        releasePaletteRow(htxpalToDestroy);
+    }
 }
 
 void Renderer::texturePaletteAnimate(C3D_HTXPAL htxpalToAnimate,
     C3D_UINT32 u32StartIndex, C3D_UINT32 u32NumEntries,
     C3D_PPALETTENTRY pclrPalette)
 {
-    throw Error(__FUNCTION__ ": Not implemented", C3D_EC_NOTIMPYET);
+    auto it = m_palettes.find(htxpalToAnimate);
+    if (it == m_palettes.end()) {
+        throw Error("Invalid palette handle", C3D_EC_BADPARAM);
+    }
+
+    if (u32StartIndex > Palette::SIZE ||
+        u32NumEntries > Palette::SIZE - u32StartIndex) {
+        throw Error("Invalid palette range", C3D_EC_BADPARAM);
+    }
+
+    // textures resolved on registration would keep their previous colors
+    if (!m_paletteTexture) {
+        throw Error("Palette animation requires ati3dcif.gpu_palettes",
+            C3D_EC_NOTIMPYET);
+    }
+
+    Palette& palette = it->second;
+    palette.update(u32StartIndex, u32NumEntries, pclrPalette);
+
+    // recorded draw calls must still use the previous colors
+    if (m_paletteTextures.find(htxpalToAnimate) != m_paletteTextures.end()) {
+        flush(FLUSH_PALETTE_ANIMATE);
+    }
+
+    m_paletteTexture->update(m_paletteRows[htxpalToAnimate], palette);
 }
 
 void Renderer::renderPrimStrip(C3D_VSTRIP vStrip, C3D_UINT32 u32NumVert)
 {
-    m_context.setRendered();
+    validateState();
+    selectMaterial();
     m_vertexStream.addPrimStrip(vStrip, u32NumVert);
 }
 
 void Renderer::renderPrimList(C3D_VLIST vList, C3D_UINT32 u32NumVert)
 {
-    m_context.setRendered();
+    validateState();
+    selectMaterial();
     m_vertexStream.addPrimList(vList, u32NumVert);
 }
 
+void Renderer::renderPrimMesh(
+    C3D_PVARRAY vMesh, C3D_PUINT32 pu32Indicies, C3D_UINT32 u32NumIndicies)
+{
+    validateState();
+    selectMaterial();
+    m_vertexStream.addPrimMesh(vMesh, pu32Indicies, u32NumIndicies);
+}
+
 void Renderer::setState(C3D_ERSID eRStateID, C3D_PRSDATA pRStateData)
 {
-    m_state.set(eRStateID, pRStateData);
+    if (static_cast<uint32_t>(eRStateID) >= C3D_ERS_NUM) {
+        throw Error("Invalid render state", C3D_EC_BADPARAM);
+    }
+
+    if (m_state.set(eRStateID, pRStateData)) {
+        stateChanged(eRStateID);
+    }
+}
+
+void Renderer::setState(C3D_ERSID eRStateID, const StateVar::Value& value)
+{
+    if (static_cast<uint32_t>(eRStateID) >= C3D_ERS_NUM) {
+        throw Error("Invalid render state", C3D_EC_BADPARAM);
+    }
+
+    if (m_state.set(eRStateID, value)) {
+        stateChanged(eRStateID);
+    }
 }
 
 void Renderer::resetState()
 {
     m_state.reset();
+
+    for (int32_t id = 0; id < C3D_ERS_NUM; id++) {
+        stateChanged(static_cast<C3D_ERSID>(id));
+    }
 }
 
-void Renderer::switchState(StateVar::Value& value)
+const FrameStats& Renderer::stats()
 {
-    // render pending polygons from the previous state
-    m_vertexStream.renderPending();
+    return m_stats.lastFrame();
 }
 
-void Renderer::vertexType(StateVar::Value& value)
+void Renderer::validateState()
 {
-    m_vertexStream.vertexType(value.evertex);
+    if (m_dirtyStates.none()) {
+        return;
+    }
+
+    // newly registered textures are uploaded right before they're selected
+    // for the first time, if that happens before their turn in the queue
+    if (m_state.get(C3D_ERS_TMAP_EN).boolean) {
+        Texture* texture = findTexture(m_state.get(C3D_ERS_TMAP_SELECT).htx);
+        if (texture && texture->pending()) {
+            m_stats.frame().textureBytesUploaded +=
+                texture->upload(*m_uploader);
+        }
+    }
+
+    // pending polygons only need to be recorded as a separate draw call if the
+    // effective GL state has changed
+    DrawState state = resolveDrawState();
+    if (state != m_drawState) {
+        if (closeCommand()) {
+            FrameStats& stats = m_stats.frame();
+            for (int32_t id = 0; id < C3D_ERS_NUM; id++) {
+                if (m_dirtyStates[id]) {
+                    stats.stateSplits[id]++;
+                }
+            }
+        }
+
+        m_drawState = state;
+    }
+
+    Material material = resolveMaterial();
+    if (memcmp(&material, &m_material, sizeof(Material)) != 0) {
+        m_material = material;
+        m_materialDirty = true;
+    }
+
+    m_dirtyStates.reset();
 }
 
-void Renderer::primType(StateVar::Value& value)
+DrawState Renderer::resolveDrawState()
 {
-    m_vertexStream.primType(value.eprim);
+    // states that have no effect in the current configuration are left at
+    // zero, so they don't make otherwise equal states differ
+    DrawState state{};
+    state.mode = GLCIF_PRIM_MODES[m_state.get(C3D_ERS_PRIM_TYPE).eprim];
+
+    if (m_state.get(C3D_ERS_TMAP_EN).boolean) {
+        Texture* texture = findTexture(m_state.get(C3D_ERS_TMAP_SELECT).htx);
+        if (texture) {
+            state.texture = texture->array()->id();
+        }
+
+        C3D_ETEXFILTER filter = m_state.get(C3D_ERS_TMAP_FILTER).etexfilter;
+        state.minFilter = GLCIF_TEXTURE_MIN_FILTER[filter];
+        state.magFilter = GLCIF_TEXTURE_MAG_FILTER[filter];
+    }
+
+    state.blendSrc = GLCIF_BLEND_FUNC[m_state.get(C3D_ERS_ALPHA_SRC).easrc];
+    state.blendDst = GLCIF_BLEND_FUNC[m_state.get(C3D_ERS_ALPHA_DST).eadst];
+
+    // depth writes are disabled along with the depth test
+    C3D_EZMODE zMode = m_state.get(C3D_ERS_Z_MODE).ezmode;
+    state.depthTest = zMode > C3D_EZMODE_TESTON;
+    if (state.depthTest) {
+        state.depthMask = GLCIF_DEPTH_MASK[zMode];
+
+        // invalid compare functions keep the previous one
+        C3D_EZCMP zCmpFunc = m_state.get(C3D_ERS_Z_CMP_FNC).ezcmp;
+        if (zCmpFunc < C3D_EZCMP_MAX) {
+            state.depthFunc = GLCIF_DEPTH_FUNC[zCmpFunc];
+        } else if (m_drawState.depthFunc) {
+            state.depthFunc = m_drawState.depthFunc;
+        } else {
+            state.depthFunc = GL_LESS;
+        }
+    }
+
+    return state;
 }
 
-void Renderer::solidColor(StateVar::Value& value)
+Material Renderer::resolveMaterial()
 {
-    C3D_COLOR color = value.color;
-    m_program.uniform4f("solidColor", color.r / 255.0f, color.g / 255.0f,
-        color.b / 255.0f, color.a / 255.0f);
+    // like the draw state, unused parameters are left at zero, so fewer
+    // materials are required
+    Material material{};
+
+    C3D_ESHADE shadeMode = m_state.get(C3D_ERS_SHADE_MODE).eshade;
+    material.shadeMode = shadeMode;
+    if (shadeMode == C3D_ESH_SOLID) {
+        C3D_COLOR color = m_state.get(C3D_ERS_SOLID_CLR).color;
+        material.solidColor[0] = color.r / 255.0f;
+        material.solidColor[1] = color.g / 255.0f;
+        material.solidColor[2] = color.b / 255.0f;
+        material.solidColor[3] = color.a / 255.0f;
+    }
+
+    material.tmapEnable = m_state.get(C3D_ERS_TMAP_EN).boolean;
+    if (material.tmapEnable) {
+        material.tmapLight = m_state.get(C3D_ERS_TMAP_LIGHT).etlight;
+        material.texOp = m_state.get(C3D_ERS_TMAP_TEXOP).etexop;
+
+        Texture* texture = findTexture(m_state.get(C3D_ERS_TMAP_SELECT).htx);
+        if (texture) {
+            material.tmapLayer = texture->layer();
+
+            // indexed textures are filtered in the shader after the palette
+            // lookup
+            auto array = texture->array();
+            if (array->indexed()) {
+                auto it = m_paletteRows.find(texture->palette());
+                if (it != m_paletteRows.end()) {
+                    material.tmapPalette = it->second + 1;
+                }
+
+                C3D_ETEXFILTER filter =
+                    m_state.get(C3D_ERS_TMAP_FILTER).etexfilter;
+                material.tmapLinear =
+                    GLCIF_TEXTURE_MAG_FILTER[filter] == GL_LINEAR;
+                material.tmapMaxLevel = array->levels() - 1;
+            }
+
+            if (material.texOp == C3D_ETEXOP_CHROMAKEY) {
+                auto ck = texture->chromaKey();
+                material.chromaKey[0] = ck.r / 255.0f;
+                material.chromaKey[1] = ck.g / 255.0f;
+                material.chromaKey[2] = ck.b / 255.0f;
+            }
+        }
+    }
+
+    return material;
 }
 
-void Renderer::shadeMode(StateVar::Value& value)
+Texture* Renderer::findTexture(C3D_HTX handle)
 {
-    m_program.uniform1i("shadeMode", value.eshade);
+    // no texture if handle is zero
+    if (handle == 0) {
+        return nullptr;
+    }
+
+    // handles are checked when they're selected, so drawing never fails on an
+    // unknown one
+    auto it = m_textures.find(handle);
+    if (it == m_textures.end()) {
+        return nullptr;
+    }
+
+    return it->second.get();
 }
 
-void Renderer::tmapEnable(StateVar::Value& value)
+void Renderer::releasePaletteRow(C3D_HTXPAL htxpal)
 {
-    C3D_BOOL enable = value.boolean;
-    m_program.uniform1i("tmapEn", enable);
+    auto it = m_paletteRows.find(htxpal);
+    if (it != m_paletteRows.end()) {
+        m_paletteTexture->release(it->second);
+        m_paletteRows.erase(it);
+    }
 }
 
-void Renderer::tmapSelect(StateVar::Value& value)
+void Renderer::selectMaterial()
 {
-    tmapSelectImpl(value.htx);
+    if (!m_materialDirty) {
+        return;
+    }
+
+    uint32_t index = m_materials.add(m_material);
+
+    // submit everything recorded so far if the table is full
+    if (index == MaterialTable::INVALID_INDEX) {
+        flush(FLUSH_MATERIALS_FULL);
+        index = m_materials.add(m_material);
+    }
+
+    m_vertexStream.material(index);
+    m_materialDirty = false;
 }
 
-void Renderer::tmapSelectImpl(C3D_HTX handle)
+void Renderer::flush(FlushReason reason)
 {
-    // unselect texture if handle is zero
-    if (handle == 0) {
-        glBindTexture(GL_TEXTURE_2D, 0);
+    closeCommand();
+
+    if (m_commands.empty()) {
         return;
     }
 
-    // check if handle is correct
-    auto it = m_textures.find(handle);
-    if (it == m_textures.end()) {
-        throw Error("Invalid texture handle", C3D_EC_BADPARAM);
+    FrameStats& stats = m_stats.frame();
+    stats.flushes[reason]++;
+
+    // generate pending mipmaps before the texture arrays are used
+    m_texturePool.update();
+
+    // upload geometry, which updates the index ranges of all commands, then
+    // merge neighboring commands with equal states
+    auto& commands = m_commands.commands();
+    stats.vertices += m_vertexStream.vertexCount();
+    stats.materials += m_materials.size();
+    stats.bytesUploaded += static_cast<uint32_t>(
+        m_vertexStream.upload(commands) + m_materials.upload());
+    stats.uniformUpdates++;
+    m_commands.merge();
+
+    for (auto& cmd : commands) {
+        applyState(cmd.state);
+        m_vertexStream.draw(cmd.state.mode, cmd.first, cmd.count);
+        stats.draws++;
+        stats.indices += cmd.count;
     }
 
-    // get texture object and bind it
-    auto texture = it->second;
-    texture->bind();
+    m_commands.clear();
+    m_commandFirst = 0;
 
-    // send chroma key color to shader
-    auto ck = texture->chromaKey();
-    m_program.uniform3f(
-        "chromaKey", ck.r / 255.0f, ck.g / 255.0f, ck.b / 255.0f);
-}
+    // the material indices are only valid within one flush
+    m_materials.clear();
+    m_materialDirty = true;
 
-void Renderer::tmapRestore() {
-    tmapSelectImpl(m_state.get(C3D_ERS_TMAP_SELECT).htx);
+    gl::Utils::checkError(__FUNCTION__);
 }
 
-void Renderer::tmapLight(StateVar::Value& value)
+bool Renderer::closeCommand()
 {
-    m_program.uniform1i("tmapLight", value.etlight);
+    // record pending polygons with the current state
+    uint32_t end = m_vertexStream.indexCount();
+    uint32_t count = end - m_commandFirst;
+    m_commands.add(m_drawState, m_commandFirst, count);
+    m_commandFirst = end;
+    return count > 0;
 }
 
-void Renderer::tmapFilter(StateVar::Value& value)
+void Renderer::applyState(const DrawState& state)
 {
-    auto filter = value.etexfilter;
-    m_sampler.parameteri(
-        GL_TEXTURE_MAG_FILTER, GLCIF_TEXTURE_MAG_FILTER[filter]);
-    m_sampler.parameteri(
-        GL_TEXTURE_MIN_FILTER, GLCIF_TEXTURE_MIN_FILTER[filter]);
+    FrameStats& stats = m_stats.frame();
+
+    auto count = [&stats](bool issued, uint32_t& counter) {
+        if (issued) {
+            counter++;
+        } else {
+            stats.stateSkips++;
+        }
+    };
+
+    count(m_glState.bindTexture(0, GL_TEXTURE_2D_ARRAY, state.texture),
+        stats.textureBinds);
+
+    // filters are zero if texturing is disabled, keep the previous ones then,
+    // the sampler is owned by this renderer, so it's shadowed here
+    if (state.minFilter) {
+        bool changed = state.minFilter != m_minFilter ||
+                       state.magFilter != m_magFilter;
+        if (changed) {
+            m_sampler.parameteri(GL_TEXTURE_MAG_FILTER, state.magFilter);
+            m_sampler.parameteri(GL_TEXTURE_MIN_FILTER, state.minFilter);
+            m_minFilter = state.minFilter;
+            m_magFilter = state.magFilter;
+        }
+        count(changed, stats.stateChanges);
+    }
+
+    count(m_glState.blendFunc(state.blendSrc, state.blendDst),
+        stats.stateChanges);
+    count(m_glState.enable(GL_DEPTH_TEST, state.depthTest),
+        stats.stateChanges);
+    count(m_glState.depthMask(state.depthMask), stats.stateChanges);
+
+    // the compare function is zero if depth testing is disabled
+    if (state.depthFunc) {
+        count(m_glState.depthFunc(state.depthFunc), stats.stateChanges);
+    }
 }
 
-void Renderer::tmapTexOp(StateVar::Value& value)
+void Renderer::stateChanged(C3D_ERSID id)
 {
-    m_program.uniform1i("texOp", value.etexop);
+    StateHandler handler = STATE_HANDLERS[id];
+    if (handler) {
+        (this->*handler)(m_state.get(id), id);
+    }
 }
 
-void Renderer::alphaSrc(StateVar::Value& value)
+void Renderer::invalidateState(const StateVar::Value& value, C3D_ERSID id)
 {
-    C3D_EASRC alphaSrc = value.easrc;
-    C3D_EADST alphaDst = m_state.get(C3D_ERS_ALPHA_DST).eadst;
-    glBlendFunc(GLCIF_BLEND_FUNC[alphaSrc], GLCIF_BLEND_FUNC[alphaDst]);
+    m_dirtyStates.set(id);
 }
 
-void Renderer::alphaDst(StateVar::Value& value)
+void Renderer::vertexType(const StateVar::Value& value, C3D_ERSID id)
 {
-    C3D_EASRC alphaSrc =  m_state.get(C3D_ERS_ALPHA_SRC).easrc;
-    C3D_EADST alphaDst = value.eadst;
-    glBlendFunc(GLCIF_BLEND_FUNC[alphaSrc], GLCIF_BLEND_FUNC[alphaDst]);
+    m_vertexStream.vertexType(value.evertex);
 }
 
-void Renderer::zCmpFunc(StateVar::Value& value)
+void Renderer::primType(const StateVar::Value& value, C3D_ERSID id)
 {
-    C3D_EZCMP func = value.ezcmp;
-    if (func < C3D_EZCMP_MAX) {
-        glDepthFunc(GLCIF_DEPTH_FUNC[func]);
-    }
+    m_vertexStream.primType(value.eprim);
+    invalidateState(value, id);
 }
 
-void Renderer::zMode(StateVar::Value& value)
+void Renderer::tmapSelect(const StateVar::Value& value, C3D_ERSID id)
 {
-    auto mode = value.ezmode;
-    glDepthMask(GLCIF_DEPTH_MASK[mode]);
+    invalidateState(value, id);
 
-    if (mode > C3D_EZMODE_TESTON) {
-        glEnable(GL_DEPTH_TEST);
-    } else {
-        glDisable(GL_DEPTH_TEST);
+    // an invalid handle unselects the texture, so it's checked again if the
+    // application retries it
+    if (value.htx != 0 && m_textures.find(value.htx) == m_textures.end()) {
+        m_state.set(id, StateVar::Value{0});
+        throw Error("Invalid texture handle", C3D_EC_BADPARAM);
     }
 }
 
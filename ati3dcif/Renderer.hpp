@@ -1,18 +1,33 @@
 #pragma once
 
+#include "BlockCompressor.hpp"
+#include "CommandBuffer.hpp"
+#include "MaterialTable.hpp"
+#include "MipmapBuilder.hpp"
+#include "PaletteTexture.hpp"
 #include "State.hpp"
+#include "Stats.hpp"
 #include "Texture.hpp"
+#include "TextureCache.hpp"
+#include "TextureDiskCache.hpp"
+#include "TextureUploader.hpp"
+#include "TexturePool.hpp"
 #include "VertexStream.hpp"
 
 #include <glrage/GLRage.hpp>
 #include <glrage_gl/Program.hpp>
 #include <glrage_gl/Sampler.hpp>
 #include <glrage_gl/Shader.hpp>
+#include <glrage_gl/StateCache.hpp>
+#include <glrage_gl/Uniform.hpp>
 #include <glrage_util/Config.hpp>
+#include <glrage_util/ThreadPool.hpp>
 
 #include <array>
+#include <bitset>
 #include <map>
 #include <memory>
+#include <set>
 
 namespace glrage {
 namespace cif {
@@ -76,48 +91,99 @@ public:
     Renderer();
     void renderBegin(C3D_HRC);
     void renderEnd();
-    void textureReg(C3D_PTMAP, C3D_PHTX);
+    void textureReg(C3D_PTMAP, C3D_HTX);
     void textureUnreg(C3D_HTX);
-    void texturePaletteCreate(C3D_ECI_TMAP_TYPE, void*, C3D_PHTXPAL);
+    void texturePaletteCreate(C3D_ECI_TMAP_TYPE, void*, C3D_HTXPAL);
     void texturePaletteDestroy(C3D_HTXPAL);
     void texturePaletteAnimate(
         C3D_HTXPAL, C3D_UINT32, C3D_UINT32, C3D_PPALETTENTRY);
     void renderPrimStrip(C3D_VSTRIP, C3D_UINT32);
     void renderPrimList(C3D_VLIST, C3D_UINT32);
+    void renderPrimMesh(C3D_PVARRAY, C3D_PUINT32, C3D_UINT32);
     void setState(C3D_ERSID eRStateID, C3D_PRSDATA pRStateData);
+    void setState(C3D_ERSID eRStateID, const StateVar::Value& value);
     void resetState();
+    const FrameStats& stats();
 
 private:
+    static const GLuint PALETTE_UNIT = 1;
+
+    typedef void (Renderer::*StateHandler)(const StateVar::Value& value,
+        C3D_ERSID id);
+
     // state functions start
-    void switchState(StateVar::Value& value);
-    void vertexType(StateVar::Value& value);
-    void primType(StateVar::Value& value);
-    void solidColor(StateVar::Value& value);
-    void shadeMode(StateVar::Value& value);
-    void tmapEnable(StateVar::Value& value);
-    void tmapSelect(StateVar::Value& value);
-    void tmapLight(StateVar::Value& value);
-    void tmapFilter(StateVar::Value& value);
-    void tmapTexOp(StateVar::Value& value);
-    void alphaSrc(StateVar::Value& value);
-    void alphaDst(StateVar::Value& value);
-    void zCmpFunc(StateVar::Value& value);
-    void zMode(StateVar::Value& value);
+    void invalidateState(const StateVar::Value& value, C3D_ERSID id);
+    void vertexType(const StateVar::Value& value, C3D_ERSID id);
+    void primType(const StateVar::Value& value, C3D_ERSID id);
+    void tmapSelect(const StateVar::Value& value, C3D_ERSID id);
     // state functions end
 
-    void tmapSelectImpl(C3D_HTX handle);
-    void tmapRestore();
+    static const std::array<StateHandler, C3D_ERS_NUM> STATE_HANDLERS;
+
+    static std::array<StateHandler, C3D_ERS_NUM> stateHandlers();
+
+    void stateChanged(C3D_ERSID id);
+    void validateState();
+    DrawState resolveDrawState();
+    Material resolveMaterial();
+    std::shared_ptr<Texture> buildTexture(
+        C3D_PTMAP tmap, const Palette& palette, uint64_t key);
+    Texture* findTexture(C3D_HTX handle);
+    void releasePaletteRow(C3D_HTXPAL htxpal);
+    void selectMaterial();
+    void flush(FlushReason reason);
+    bool closeCommand();
+    void applyState(const DrawState& state);
 
     Context& m_context{GLRage::getContext()};
     Config& m_config{GLRage::getConfig()};
+    gl::StateCache& m_glState{GLRage::getGLState()};
     bool m_wireframe;
+    bool m_shareTextures;
+    TexturePool m_texturePool;
+    TextureCache m_textureCache;
+    uint32_t m_textureBytesShared{0};
     std::map<C3D_HTX, std::shared_ptr<Texture>> m_textures;
-    std::map<C3D_HTXPAL, std::vector<C3D_PALETTENTRY>> m_palettes;
-    int32_t m_paletteID{0};
+    std::map<C3D_HTXPAL, Palette> m_palettes;
+
+    // palettes of indexed textures are resolved in the shader if enabled,
+    // rows stay allocated until the palette is destroyed and no registered
+    // texture depends on it anymore
+    std::unique_ptr<PaletteTexture> m_paletteTexture;
+    std::map<C3D_HTXPAL, uint32_t> m_paletteRows;
+    std::map<C3D_HTXPAL, std::set<C3D_HTX>> m_paletteTextures;
+    std::vector<uint8_t> m_scratch;
+    std::unique_ptr<TextureUploader> m_uploader;
+
+    // optional CPU conversion and mipmap generation, the converted chains may
+    // be stored in a file for later sessions
+    std::unique_ptr<ThreadPool> m_threadPool;
+    std::unique_ptr<MipmapBuilder> m_mipmapBuilder;
+    std::unique_ptr<TextureDiskCache> m_diskCache;
+
+    // converted chains are optionally compressed before they're uploaded
+    std::unique_ptr<BlockCompressor> m_blockCompressor;
+    std::vector<uint8_t> m_compressed;
     gl::Program m_program;
+    gl::Uniform<glm::mat4> m_matProjection;
+    gl::Uniform<glm::mat4> m_matModelView;
     gl::Sampler m_sampler;
     VertexStream m_vertexStream;
+    CommandBuffer m_commands;
+    MaterialTable m_materials;
+    Material m_material{};
+    bool m_materialDirty{true};
+    uint32_t m_commandFirst{0};
+    DrawState m_drawState{};
+    GLint m_minFilter{0};
+    GLint m_magFilter{0};
     State m_state;
+    std::bitset<C3D_ERS_NUM> m_dirtyStates;
+    Stats m_stats;
+    uint32_t m_streamWraps{0};
+    uint32_t m_streamWaits{0};
+    uint32_t m_listRefs{0};
+    uint32_t m_listCopies{0};
 };
 
 } // namespace cif
@@ -20,16 +20,16 @@ State::State()
           {C3D_EASRC{C3D_EASRC_ONE}},                   // C3D_ERS_ALPHA_SRC
           {C3D_EADST{C3D_EADST_ZERO}},                  // C3D_ERS_ALPHA_DST
           {C3D_PVOID{NULL}},                            // C3D_ERS_SURF_DRAW_PTR
-          {C3D_UINT32{NULL}},                           // C3D_ERS_SURF_DRAW_PITCH
+          {C3D_UINT32{0}},                              // C3D_ERS_SURF_DRAW_PITCH
           {C3D_EPIXFMT{C3D_EPF_RGB8888}},               // C3D_ERS_SURF_DRAW_PF
-          {C3D_RECT{NULL}},                             // C3D_ERS_SURF_VPORT
+          {C3D_RECT{}},                                 // C3D_ERS_SURF_VPORT
           {C3D_BOOL{C3D_FALSE}},                        // C3D_ERS_FOG_EN
           {C3D_BOOL{C3D_TRUE}},                         // C3D_ERS_DITHER_EN
           {C3D_EZCMP{C3D_EZCMP_ALWAYS}},                // C3D_ERS_Z_CMP_FNC
           {C3D_EZMODE{C3D_EZMODE_OFF}},                 // C3D_ERS_Z_MODE
           {C3D_PVOID{NULL}},                            // C3D_ERS_SURF_Z_PTR
-          {C3D_UINT32{NULL}},                           // C3D_ERS_SURF_Z_PITCH
-          {C3D_RECT{NULL}},                             // C3D_ERS_SURF_SCISSOR
+          {C3D_UINT32{0}},                              // C3D_ERS_SURF_Z_PITCH
+          {C3D_RECT{}},                                 // C3D_ERS_SURF_SCISSOR
           {C3D_BOOL{C3D_FALSE}},                        // C3D_ERS_COMPOSITE_EN
           {C3D_HTX{NULL}},                              // C3D_ERS_COMPOSITE_SELECT
           {C3D_ETEXCOMPFCN{C3D_ETEXCOMPFCN_MAX}},       // C3D_ERS_COMPOSITE_FNC
@@ -48,9 +48,9 @@ State::State()
 {
 }
 
-void State::set(C3D_ERSID id, C3D_PRSDATA data)
+bool State::set(C3D_ERSID id, C3D_PRSDATA data)
 {
-    m_vars[id].set(data);
+    return m_vars[id].set(data);
 }
 
 const StateVar::Value& State::get(C3D_ERSID id)
@@ -58,9 +58,9 @@ const StateVar::Value& State::get(C3D_ERSID id)
     return m_vars[id].get();
 }
 
-void State::set(C3D_ERSID id, const StateVar::Value& value)
+bool State::set(C3D_ERSID id, const StateVar::Value& value)
 {
-    m_vars[id].set(value);
+    return m_vars[id].set(value);
 }
 
 void State::reset()
@@ -70,17 +70,5 @@ void State::reset()
     }
 }
 
-void State::registerObserver(const StateVar::Observer& observer)
-{
-    for (auto& var : m_vars) {
-        var.registerObserver(observer);
-    }
-}
-
-void State::registerObserver(const StateVar::Observer& observer, C3D_ERSID id)
-{
-    m_vars[id].registerObserver(observer);
-}
-
 } // namespace cif
 } // namespace glrage
\ No newline at end of file
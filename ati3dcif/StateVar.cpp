@@ -3,19 +3,26 @@
 namespace glrage {
 namespace cif {
 
-void StateVar::set(C3D_PRSDATA pRStateData)
+bool StateVar::set(C3D_PRSDATA pRStateData)
 {
-    Value valueTmp{0};
-    memcpy(&valueTmp.raw[0], pRStateData, m_size);
-    set(valueTmp);
+    // only the bytes of the actual type are compared, the rest of the value is
+    // always zero
+    if (memcmp(&m_value.raw[0], pRStateData, m_size) == 0) {
+        return false;
+    }
+
+    memcpy(&m_value.raw[0], pRStateData, m_size);
+    return true;
 }
 
-void StateVar::set(const Value& value)
+bool StateVar::set(const Value& value)
 {
-    if (m_value.raw != value.raw) {
-        m_value = value;
-        notify();
+    if (m_value.raw == value.raw) {
+        return false;
     }
+
+    m_value = value;
+    return true;
 }
 
 const StateVar::Value& StateVar::get()
@@ -26,19 +33,6 @@ const StateVar::Value& StateVar::get()
 void StateVar::reset()
 {
     m_value = m_valueDefault;
-    notify();
-}
-
-void StateVar::registerObserver(const Observer& observer)
-{
-    m_observers.push_back(observer);
-}
-
-void StateVar::notify()
-{
-    for (auto& observer : m_observers) {
-        observer(m_value);
-    }
 }
 
 } // namespace cif
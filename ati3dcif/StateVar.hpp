@@ -3,8 +3,8 @@
 #include "ati3dcif.hpp"
 
 #include <array>
-#include <vector>
-#include <functional>
+#include <cstring>
+#include <stdexcept>
 
 namespace glrage {
 namespace cif {
@@ -38,8 +38,6 @@ public:
         std::array<uint8_t, sizeof(C3D_RECT)> raw;
     };
 
-    typedef std::function<void(Value&)> Observer;
-
     template <typename T>
     StateVar(const T& value)
     {
@@ -55,19 +53,15 @@ public:
         m_valueDefault = m_value;
     }
 
-    void set(C3D_PRSDATA pRStateData);
-    void set(const Value& value);
+    bool set(C3D_PRSDATA pRStateData);
+    bool set(const Value& value);
     const Value& get();
     void reset();
-    void registerObserver(const Observer& observer);
 
 private:
-    void notify();
-
     size_t m_size;
     Value m_value{0};
     Value m_valueDefault{0};
-    std::vector<Observer> m_observers;
 };
 
 } // namespace cif
@@ -0,0 +1,133 @@
+#include "Stats.hpp"
+#include "Utils.hpp"
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+const char* FLUSH_REASON_NAMES[] = {
+    "flush_frame_end", "flush_texture_unreg", "flush_materials_full",
+    "flush_palette_animate",
+};
+
+void accumulate(FrameStats& dst, const FrameStats& src)
+{
+    dst.draws += src.draws;
+    dst.vertices += src.vertices;
+    dst.indices += src.indices;
+    dst.bytesUploaded += src.bytesUploaded;
+    dst.streamWraps += src.streamWraps;
+    dst.streamWaits += src.streamWaits;
+    dst.listRefs += src.listRefs;
+    dst.listCopies += src.listCopies;
+    dst.textureBinds += src.textureBinds;
+    dst.stateChanges += src.stateChanges;
+    dst.stateSkips += src.stateSkips;
+    dst.uniformUpdates += src.uniformUpdates;
+    dst.uniformSkips += src.uniformSkips;
+    dst.materials += src.materials;
+    dst.textureRegs += src.textureRegs;
+    dst.textureHits += src.textureHits;
+    dst.textureDiskHits += src.textureDiskHits;
+    dst.textureBytesUploaded += src.textureBytesUploaded;
+    dst.textureBytesShared = src.textureBytesShared;
+    dst.frameTime += src.frameTime;
+    dst.waitTime += src.waitTime;
+
+    for (size_t i = 0; i < dst.flushes.size(); i++) {
+        dst.flushes[i] += src.flushes[i];
+    }
+
+    for (size_t i = 0; i < dst.stateSplits.size(); i++) {
+        dst.stateSplits[i] += src.stateSplits[i];
+    }
+}
+
+} // namespace
+
+void Stats::open(const std::wstring& path, uint32_t interval)
+{
+    m_file.open(path, std::ofstream::trunc);
+    m_intervalLength = interval > 0 ? interval : 1;
+
+    if (m_file) {
+        writeHeader();
+    }
+}
+
+FrameStats& Stats::frame()
+{
+    return m_frame;
+}
+
+const FrameStats& Stats::lastFrame()
+{
+    return m_lastFrame;
+}
+
+void Stats::endFrame()
+{
+    m_lastFrame = m_frame;
+    m_frame = FrameStats{};
+    m_frameNumber++;
+
+    if (!m_file.is_open()) {
+        return;
+    }
+
+    // write the totals of the interval, so short spikes are not lost
+    accumulate(m_interval, m_lastFrame);
+    if (++m_intervalFrames >= m_intervalLength) {
+        writeRow();
+        m_interval = FrameStats{};
+        m_intervalFrames = 0;
+    }
+}
+
+void Stats::writeHeader()
+{
+    m_file << "frame,frames,draws,vertices,indices,bytes_uploaded,"
+              "stream_wraps,stream_waits,list_refs,list_copies,"
+              "texture_binds,state_changes,state_skips,uniform_updates,"
+              "uniform_skips,materials,texture_regs,texture_hits,"
+              "texture_disk_hits,texture_bytes_uploaded,"
+              "texture_bytes_shared,frame_ms,wait_ms";
+
+    for (auto name : FLUSH_REASON_NAMES) {
+        m_file << "," << name;
+    }
+
+    for (int32_t i = 0; i < C3D_ERS_NUM; i++) {
+        m_file << ",split_" << C3D_ERSID_NAMES[i];
+    }
+
+    m_file << std::endl;
+}
+
+void Stats::writeRow()
+{
+    const FrameStats& s = m_interval;
+    m_file << m_frameNumber << "," << m_intervalFrames << "," << s.draws << ","
+           << s.vertices << "," << s.indices << "," << s.bytesUploaded << ","
+           << s.streamWraps << "," << s.streamWaits << "," << s.listRefs
+           << "," << s.listCopies << "," << s.textureBinds << ","
+           << s.stateChanges << "," << s.stateSkips << "," << s.uniformUpdates
+           << "," << s.uniformSkips << "," << s.materials << ","
+           << s.textureRegs << "," << s.textureHits << "," << s.textureDiskHits
+           << "," << s.textureBytesUploaded << "," << s.textureBytesShared
+           << "," << s.frameTime << "," << s.waitTime;
+
+    for (auto count : s.flushes) {
+        m_file << "," << count;
+    }
+
+    for (auto count : s.stateSplits) {
+        m_file << "," << count;
+    }
+
+    m_file << std::endl;
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ati3dcif.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace glrage {
+namespace cif {
+
+// reasons for submitting all recorded draw calls
+enum FlushReason
+{
+    FLUSH_FRAME_END,
+    FLUSH_TEXTURE_UNREG,
+    FLUSH_MATERIALS_FULL,
+    FLUSH_PALETTE_ANIMATE,
+    FLUSH_REASON_NUM
+};
+
+// rendering counters of a single frame
+struct FrameStats
+{
+    uint32_t draws;
+    uint32_t vertices;
+    uint32_t indices;
+    uint32_t bytesUploaded;
+
+    // stream buffer segments that were reused and the times the GPU was
+    // still reading from them
+    uint32_t streamWraps;
+    uint32_t streamWaits;
+
+    // vertex references of primitive lists and the vertices that had to be
+    // copied for them, the rest were shared within a batch
+    uint32_t listRefs;
+    uint32_t listCopies;
+
+    uint32_t textureBinds;
+    uint32_t stateChanges;
+    uint32_t stateSkips;
+    uint32_t uniformUpdates;
+    uint32_t uniformSkips;
+    uint32_t materials;
+    uint32_t textureRegs;
+    uint32_t textureHits;
+    uint32_t textureDiskHits;
+    uint32_t textureBytesUploaded;
+
+    // video memory currently saved by textures shared between handles with
+    // identical content
+    uint32_t textureBytesShared;
+
+    // duration of the last presented frame and the time spent waiting for
+    // the GPU in it, in milliseconds
+    float frameTime;
+    float waitTime;
+
+    std::array<uint32_t, FLUSH_REASON_NUM> flushes;
+
+    // draw commands that were closed by a change of the given state
+    std::array<uint32_t, C3D_ERS_NUM> stateSplits;
+};
+
+// Collects the counters of the current frame and optionally writes them to a
+// CSV file in regular intervals.
+class Stats
+{
+public:
+    void open(const std::wstring& path, uint32_t interval);
+    FrameStats& frame();
+    const FrameStats& lastFrame();
+    void endFrame();
+
+private:
+    void writeHeader();
+    void writeRow();
+
+    FrameStats m_frame{};
+    FrameStats m_lastFrame{};
+    FrameStats m_interval{};
+    uint32_t m_intervalFrames = 0;
+    uint32_t m_intervalLength = 0;
+    uint32_t m_frameNumber = 0;
+    std::ofstream m_file;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "Texels.hpp"
+
+#include <emmintrin.h>
+
+namespace glrage {
+namespace cif {
+
+void toggleAlpha1555(const uint16_t* src, size_t count, uint16_t* dst)
+{
+    const __m128i mask = _mm_set1_epi16(static_cast<short>(0x8000));
+
+    // eight texels at a time, the remainder one at a time
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i texels =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+            _mm_xor_si128(texels, mask));
+    }
+
+    for (; i < count; i++) {
+        dst[i] = src[i] ^ 0x8000;
+    }
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
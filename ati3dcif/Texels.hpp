@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace glrage {
+namespace cif {
+
+// copies RGB1555 texels with the alpha bit inverted, since CIF uses the bit
+// for transparency and GL for opacity
+void toggleAlpha1555(const uint16_t* src, size_t count, uint16_t* dst);
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
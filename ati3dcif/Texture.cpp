@@ -1,122 +1,152 @@
 #include "Texture.hpp"
 #include "Error.hpp"
+#include "Texels.hpp"
 #include "Utils.hpp"
 
+#include <glrage_gl/StateCache.hpp>
 #include <glrage_gl/Utils.hpp>
 #include <glrage_util/Logger.hpp>
 
 #include <algorithm>
-#include <vector>
 #include <cstdint>
+#include <cstring>
+#include <vector>
 
 namespace glrage {
 namespace cif {
 
-Texture::Texture()
-    : gl::Texture(GL_TEXTURE_2D)
+namespace {
+
+// staged levels start on 16 byte boundaries, which satisfies the alignment of
+// all pixel types
+inline size_t align(size_t size)
+{
+    return (size + 15) & ~size_t(15);
+}
+
+} // namespace
+
+Texture::Texture(std::shared_ptr<TextureArray> array)
+    : m_array(array)
+    , m_layer(array->allocate())
 {
 }
 
 Texture::~Texture()
 {
+    m_array->release(m_layer);
 }
 
-void Texture::load(C3D_PTMAP tmap, std::vector<C3D_PALETTENTRY>& palette)
+void Texture::load(
+    C3D_PTMAP tmap, const Palette& palette, TextureUploader& uploader)
 {
     m_chromaKey = tmap->clrTexChromaKey;
+    m_palette = tmap->htxpalTexPalette;
 
-    // convert and generate texture for each level
     uint32_t width = 1 << tmap->u32MaxMapXSizeLg2;
     uint32_t height = 1 << tmap->u32MaxMapYSizeLg2;
-    uint32_t size = width * height;
 
     uint32_t levels = 1;
     if (tmap->bMipMap) {
         levels = std::max(tmap->u32MaxMapXSizeLg2, tmap->u32MaxMapYSizeLg2) + 1;
     }
 
-    for (uint32_t level = 0; level < levels; level++) {
-        LOG_INFO("level %d (%dx%d)", level, width, height);
+    // select the upload format and the texel size in the staging buffer
+    GLenum format;
+    GLenum type;
+    uint32_t texel;
+    switch (tmap->eTexFormat) {
+        case C3D_ETF_RGB1555:
+            format = GL_BGRA;
+            type = GL_UNSIGNED_SHORT_1_5_5_5_REV;
+            texel = 2;
+            break;
 
-        // convert texture data
-        switch (tmap->eTexFormat) {
-            case C3D_ETF_RGB1555: {
-                uint16_t* src = static_cast<uint16_t*>(tmap->apvLevels[level]);
+        case C3D_ETF_RGB332:
+            format = GL_RGB;
+            type = GL_UNSIGNED_BYTE_3_3_2;
+            texel = 1;
+            break;
 
-                // toggle alpha bit, which has the opposite meaning in OpenGL
-                for (uint32_t i = 0; i < size; i++) {
-                    src[i] ^= 1 << 15;
-                }
+        case C3D_ETF_RGB565:
+            format = GL_RGB;
+            type = GL_UNSIGNED_SHORT_5_6_5_REV;
+            texel = 2;
+            break;
 
-                // upload texture data
-                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0,
-                    GL_BGRA, GL_UNSIGNED_SHORT_1_5_5_5_REV,
-                    tmap->apvLevels[level]);
+        case C3D_ETF_RGB4444:
+            format = GL_BGRA;
+            type = GL_UNSIGNED_SHORT_4_4_4_4_REV;
+            texel = 2;
+            break;
 
-                break;
+        case C3D_ETF_CI8:
+            // indexed arrays keep the indices, they're resolved with the
+            // palette texture in the shader
+            if (m_array->indexed()) {
+                format = GL_RED;
+                type = GL_UNSIGNED_BYTE;
+                texel = 1;
+            } else {
+                format = GL_RGBA;
+                type = GL_UNSIGNED_BYTE;
+                texel = 4;
             }
+            break;
 
-            case C3D_ETF_RGB332: {
-                glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, width, height, 0,
-                    GL_RGB, GL_UNSIGNED_BYTE_3_3_2, tmap->apvLevels[level]);
-                break;
-            }
+        default:
+            throw Error("Unsupported texture format: " +
+                            std::string(C3D_ETEXFMT_NAMES[tmap->eTexFormat]),
+                C3D_EC_NOTIMPYET);
+    }
 
-            case C3D_ETF_RGB565: {
-                glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, width, height, 0,
-                    GL_RGB, GL_UNSIGNED_SHORT_5_6_5_REV,
-                    tmap->apvLevels[level]);
-                break;
-            }
+    // all levels share one staging buffer
+    std::vector<StagedLevel> staged;
+    size_t size = 0;
+    for (uint32_t level = 0; level < levels; level++) {
+        staged.push_back({level, format, type, size});
+        size += align(std::max(1u, width >> level) *
+                      std::max(1u, height >> level) * texel);
+    }
 
-            case C3D_ETF_RGB4444: {
-                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0,
-                    GL_BGRA, GL_UNSIGNED_SHORT_4_4_4_4_REV,
-                    tmap->apvLevels[level]);
-                break;
-            }
+    uint8_t* dst = stage(staged, size, uploader);
 
-            case C3D_ETF_CI8: {
-                uint8_t* src = static_cast<uint8_t*>(tmap->apvLevels[level]);
-                std::vector<uint8_t> dst(size * 4);
-
-                // Resolve indices to RGBA, which requires less code and is
-                // faster than texture palettes in shaders.
-                // Modern hardware really doesn't care about a few KB more or
-                // less per texture anyway.
-                for (uint32_t i = 0; i < size; i++) {
-                    C3D_PALETTENTRY c = palette[src[i]];
-                    dst[i * 4 + 0] = c.r;
-                    dst[i * 4 + 1] = c.g;
-                    dst[i * 4 + 2] = c.b;
-                    dst[i * 4 + 3] = 0xff;
-                }
-
-                // upload texture data
-                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0,
-                    GL_RGBA, GL_UNSIGNED_BYTE, &dst[0]);
-
-                break;
-            }
+    // convert texture data for each level
+    for (uint32_t level = 0; level < levels; level++) {
+        LOG_INFO("level %d (%dx%d)", level, width, height);
 
-            default:
-                throw Error(
-                    "Unsupported texture format: " +
-                        std::string(C3D_ETEXFMT_NAMES[tmap->eTexFormat]),
-                    C3D_EC_NOTIMPYET);
+        const void* src = tmap->apvLevels[level];
+        uint8_t* levelDst = dst + staged[level].offset;
+        uint32_t count = width * height;
+
+        if (tmap->eTexFormat == C3D_ETF_RGB1555) {
+            // toggle alpha bit, which has the opposite meaning in OpenGL,
+            // the application's texture data is left untouched, since it
+            // may be registered again
+            toggleAlpha1555(static_cast<const uint16_t*>(src), count,
+                reinterpret_cast<uint16_t*>(levelDst));
+        } else if (format == GL_RGBA) {
+            // Resolve indices to RGBA, which requires less code and is
+            // faster than texture palettes in shaders.
+            // Modern hardware really doesn't care about a few KB more or
+            // less per texture anyway.
+            palette.expand(static_cast<const uint8_t*>(src), count,
+                reinterpret_cast<uint32_t*>(levelDst));
+        } else {
+            std::memcpy(levelDst, src, count * texel);
         }
 
         // set dimensions for next level
         width = std::max(1u, width / 2);
         height = std::max(1u, height / 2);
-        size = width * height;
     }
 
-    // generate mipmaps automatically if the application doesn't provide any
-    if (levels == 1) {
-        bind();
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
+    finishStaging();
+
+    // generate mipmaps automatically if the application doesn't provide any,
+    // averaged indices are meaningless though, so indexed arrays only have a
+    // single level then
+    m_generateMipmaps = levels == 1 && !m_array->indexed();
 
     // FIXME: sampler object overrides these parameters
     // if (tmap->u32Size > 68) {
@@ -133,8 +163,97 @@ void Texture::load(C3D_PTMAP tmap, std::vector<C3D_PALETTENTRY>& palette)
     //        GL_CLAMP_TO_EDGE);
     //    }
     //}
+}
+
+void Texture::loadChain(
+    C3D_PTMAP tmap, const uint8_t* chain, TextureUploader& uploader)
+{
+    m_chromaKey = tmap->clrTexChromaKey;
+    m_palette = tmap->htxpalTexPalette;
+
+    // the chain was converted to RGBA8 or compressed to the format of the
+    // array and contains all of its levels
+    std::vector<StagedLevel> staged;
+    size_t size = 0;
+    for (uint32_t level = 0; level < m_array->levels(); level++) {
+        staged.push_back({level, GL_RGBA, GL_UNSIGNED_BYTE, size});
+        size += m_array->levelSize(level);
+    }
+
+    std::memcpy(stage(staged, size, uploader), chain, size);
+    finishStaging();
+    m_generateMipmaps = false;
+}
+
+bool Texture::pending()
+{
+    return !m_stagedLevels.empty();
+}
+
+uint32_t Texture::upload(TextureUploader& uploader)
+{
+    if (!pending()) {
+        return 0;
+    }
+
+    m_array->bind();
+    m_staging.buffer->bind();
+
+    // rows of small levels aren't padded to four bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    bool compressed = m_array->format() == TEXTURE_BC1 ||
+                      m_array->format() == TEXTURE_BC3;
+    for (auto& staged : m_stagedLevels) {
+        auto data = reinterpret_cast<const void*>(staged.offset);
+        if (compressed) {
+            m_array->compressedSubImage(staged.level, m_layer,
+                m_array->levelSize(staged.level), data);
+        } else {
+            m_array->subImage(
+                staged.level, m_layer, staged.format, staged.type, data);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // other pixel transfers expect client memory
+    gl::StateCache::current().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (m_generateMipmaps) {
+        m_array->invalidateMipmaps();
+    }
+
+    uint32_t size = m_stagedSize;
+    uploader.release(std::move(m_staging));
+    m_staging = {};
+    m_stagedLevels.clear();
+    m_stagedSize = 0;
 
     gl::Utils::checkError(__FUNCTION__);
+
+    return size;
+}
+
+uint8_t* Texture::stage(const std::vector<StagedLevel>& levels, size_t size,
+    TextureUploader& uploader)
+{
+    m_staging = uploader.acquire(size);
+
+    auto data = static_cast<uint8_t*>(m_staging.buffer->map(GL_WRITE_ONLY));
+    if (!data) {
+        gl::StateCache::current().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        throw Error("Can't map texture staging buffer", C3D_EC_MEMALLOCFAIL);
+    }
+
+    m_stagedLevels = levels;
+    m_stagedSize = static_cast<uint32_t>(size);
+    return data;
+}
+
+void Texture::finishStaging()
+{
+    m_staging.buffer->bind();
+    m_staging.buffer->unmap();
+    gl::StateCache::current().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
 
 C3D_COLOR& Texture::chromaKey()
@@ -142,5 +261,20 @@ C3D_COLOR& Texture::chromaKey()
     return m_chromaKey;
 }
 
+C3D_HTXPAL Texture::palette()
+{
+    return m_palette;
+}
+
+std::shared_ptr<TextureArray> Texture::array()
+{
+    return m_array;
+}
+
+uint32_t Texture::layer()
+{
+    return m_layer;
+}
+
 } // namespace cif
 } // namespace glrage
\ No newline at end of file
@@ -1,24 +1,55 @@
 #pragma once
 
+#include "Palette.hpp"
+#include "TextureArray.hpp"
+#include "TextureUploader.hpp"
 #include "ati3dcif.hpp"
 
+#include <memory>
 #include <vector>
 
-#include <glrage_gl/Texture.hpp>
-
 namespace glrage {
 namespace cif {
 
-class Texture : public gl::Texture
+// registered texture, stored in a layer of a texture array
+class Texture
 {
 public:
-    Texture();
+    Texture(std::shared_ptr<TextureArray> array);
     ~Texture();
-    void load(C3D_PTMAP tmap, std::vector<C3D_PALETTENTRY>& palette);
+    void load(C3D_PTMAP tmap, const Palette& palette,
+        TextureUploader& uploader);
+    void loadChain(
+        C3D_PTMAP tmap, const uint8_t* chain, TextureUploader& uploader);
+    bool pending();
+    uint32_t upload(TextureUploader& uploader);
     C3D_COLOR& chromaKey();
+    C3D_HTXPAL palette();
+    std::shared_ptr<TextureArray> array();
+    uint32_t layer();
 
 private:
+    // level data waiting in the staging buffer
+    struct StagedLevel
+    {
+        uint32_t level;
+        GLenum format;
+        GLenum type;
+        size_t offset;
+    };
+
+    uint8_t* stage(const std::vector<StagedLevel>& levels, size_t size,
+        TextureUploader& uploader);
+    void finishStaging();
+
+    std::shared_ptr<TextureArray> m_array;
+    uint32_t m_layer;
     C3D_COLOR m_chromaKey;
+    C3D_HTXPAL m_palette;
+    TextureUploader::StagingBuffer m_staging;
+    std::vector<StagedLevel> m_stagedLevels;
+    uint32_t m_stagedSize{0};
+    bool m_generateMipmaps{false};
 };
 
 } // namespace cif
@@ -0,0 +1,197 @@
+#include "TextureArray.hpp"
+#include "Error.hpp"
+
+#include <glrage_gl/Utils.hpp>
+
+#include <algorithm>
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+const GLint INTERNAL_FORMATS[] = {
+    GL_RGBA8,                         // TEXTURE_RGBA8
+    GL_R8,                            // TEXTURE_INDEX8
+    GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, // TEXTURE_BC1
+    GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, // TEXTURE_BC3
+};
+
+} // namespace
+
+TextureArray::TextureArray(
+    uint32_t width, uint32_t height, bool appMipmaps, TextureFormat format)
+    : gl::Texture(GL_TEXTURE_2D_ARRAY)
+    , m_width(width)
+    , m_height(height)
+    , m_appMipmaps(appMipmaps)
+    , m_format(format)
+{
+    // always allocate a full mipmap chain, it's either provided by the
+    // application or generated, except for indices, which can't be averaged
+    m_levels = 1;
+    if (appMipmaps || format != TEXTURE_INDEX8) {
+        for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+            m_levels++;
+        }
+    }
+
+    // limit the storage per array, including all mipmap levels, but always
+    // allocate at least one layer for textures that exceed the limit on
+    // their own
+    uint32_t layers = MAX_ARRAY_SIZE / layerSize();
+    layers = std::min(std::max(layers, 1u), MAX_LAYERS);
+
+    // hand out the lowest layers first
+    m_freeLayers.resize(layers);
+    for (uint32_t i = 0; i < layers; i++) {
+        m_freeLayers[i] = layers - i - 1;
+    }
+
+    // all formats are converted to RGBA8 so they can share an array, only
+    // indexed textures keep their 8 bit palette indices and compressed
+    // textures their blocks
+    GLint internalFormat = INTERNAL_FORMATS[format];
+
+    bind();
+    for (uint32_t level = 0; level < m_levels; level++) {
+        GLsizei levelWidth = std::max(1u, width >> level);
+        GLsizei levelHeight = std::max(1u, height >> level);
+
+        if (format == TEXTURE_BC1 || format == TEXTURE_BC3) {
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat,
+                levelWidth, levelHeight, layers, 0, levelSize(level) * layers,
+                nullptr);
+        } else {
+            GLenum dataFormat = format == TEXTURE_INDEX8 ? GL_RED : GL_RGBA;
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat,
+                levelWidth, levelHeight, layers, 0, dataFormat,
+                GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+
+    gl::Utils::checkError(__FUNCTION__);
+}
+
+uint32_t TextureArray::width()
+{
+    return m_width;
+}
+
+uint32_t TextureArray::height()
+{
+    return m_height;
+}
+
+uint32_t TextureArray::levels()
+{
+    return m_levels;
+}
+
+uint32_t TextureArray::levelSize(uint32_t level)
+{
+    uint32_t width = std::max(1u, m_width >> level);
+    uint32_t height = std::max(1u, m_height >> level);
+
+    switch (m_format) {
+        case TEXTURE_INDEX8:
+            return width * height;
+
+        // compressed formats store blocks of 4x4 texels, even if the level is
+        // smaller than that
+        case TEXTURE_BC1:
+            return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+
+        case TEXTURE_BC3:
+            return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+
+        default:
+            return width * height * 4;
+    }
+}
+
+uint32_t TextureArray::layerSize()
+{
+    // video memory of a single layer, including all mipmap levels
+    uint32_t size = 0;
+    for (uint32_t level = 0; level < m_levels; level++) {
+        size += levelSize(level);
+    }
+    return size;
+}
+
+bool TextureArray::appMipmaps()
+{
+    return m_appMipmaps;
+}
+
+TextureFormat TextureArray::format()
+{
+    return m_format;
+}
+
+bool TextureArray::indexed()
+{
+    return m_format == TEXTURE_INDEX8;
+}
+
+bool TextureArray::full()
+{
+    return m_freeLayers.empty();
+}
+
+uint32_t TextureArray::allocate()
+{
+    if (m_freeLayers.empty()) {
+        throw Error("No free texture array layer", C3D_EC_MEMALLOCFAIL);
+    }
+
+    uint32_t layer = m_freeLayers.back();
+    m_freeLayers.pop_back();
+    return layer;
+}
+
+void TextureArray::release(uint32_t layer)
+{
+    m_freeLayers.push_back(layer);
+}
+
+void TextureArray::subImage(uint32_t level, uint32_t layer, GLenum format,
+    GLenum type, const void* data)
+{
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+        std::max(1u, m_width >> level), std::max(1u, m_height >> level), 1,
+        format, type, data);
+}
+
+void TextureArray::compressedSubImage(
+    uint32_t level, uint32_t layer, uint32_t size, const void* data)
+{
+    glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+        std::max(1u, m_width >> level), std::max(1u, m_height >> level), 1,
+        INTERNAL_FORMATS[m_format], size, data);
+}
+
+void TextureArray::invalidateMipmaps()
+{
+    m_mipmapsDirty = true;
+}
+
+void TextureArray::updateMipmaps()
+{
+    // mipmaps are generated for all layers at once, so defer it until the
+    // array is actually used
+    if (!m_mipmapsDirty) {
+        return;
+    }
+
+    bind();
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    m_mipmapsDirty = false;
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "TextureFormat.hpp"
+#include "ati3dcif.hpp"
+
+#include <glrage_gl/Texture.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace glrage {
+namespace cif {
+
+// Array of equally sized textures. Each registered texture occupies one layer,
+// so textures of the same array can be drawn without rebinding.
+class TextureArray : public gl::Texture
+{
+public:
+    TextureArray(uint32_t width, uint32_t height, bool appMipmaps,
+        TextureFormat format);
+    uint32_t width();
+    uint32_t height();
+    uint32_t levels();
+    uint32_t levelSize(uint32_t level);
+    uint32_t layerSize();
+    bool appMipmaps();
+    TextureFormat format();
+    bool indexed();
+    bool full();
+    uint32_t allocate();
+    void release(uint32_t layer);
+    void subImage(uint32_t level, uint32_t layer, GLenum format, GLenum type,
+        const void* data);
+    void compressedSubImage(
+        uint32_t level, uint32_t layer, uint32_t size, const void* data);
+    void invalidateMipmaps();
+    void updateMipmaps();
+
+private:
+    static const uint32_t MAX_ARRAY_SIZE = 16 << 20;
+    static const uint32_t MAX_LAYERS = 256;
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_levels;
+    bool m_appMipmaps;
+    TextureFormat m_format;
+    bool m_mipmapsDirty = false;
+    std::vector<uint32_t> m_freeLayers;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "TextureCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+const uint64_t HASH_MUL = 0xc6a4a7935bd1e995ull;
+const int HASH_SHIFT = 47;
+
+// MurmurHash64A, consumes eight bytes per step and can be continued over
+// multiple blocks of data
+uint64_t hash(uint64_t h, const void* data, size_t size)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    h ^= size * HASH_MUL;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t k;
+        std::memcpy(&k, bytes + i, sizeof(k));
+        k *= HASH_MUL;
+        k ^= k >> HASH_SHIFT;
+        k *= HASH_MUL;
+        h ^= k;
+        h *= HASH_MUL;
+    }
+
+    if (i < size) {
+        uint64_t k = 0;
+        std::memcpy(&k, bytes + i, size - i);
+        h ^= k;
+        h *= HASH_MUL;
+    }
+
+    h ^= h >> HASH_SHIFT;
+    h *= HASH_MUL;
+    h ^= h >> HASH_SHIFT;
+    return h;
+}
+
+// size of a texel in the application's texture data, zero if the format is
+// not supported
+uint32_t texelSize(C3D_ETEXFMT format)
+{
+    switch (format) {
+        case C3D_ETF_RGB1555:
+        case C3D_ETF_RGB565:
+        case C3D_ETF_RGB4444:
+            return 2;
+
+        case C3D_ETF_RGB332:
+        case C3D_ETF_CI8:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+} // namespace
+
+uint64_t TextureCache::key(C3D_PTMAP tmap, const Palette* palette)
+{
+    uint32_t texel = texelSize(tmap->eTexFormat);
+    if (texel == 0) {
+        return 0;
+    }
+
+    // everything Texture::load reads from the map, the palette handle is
+    // replaced by the palette's content if it's resolved on registration
+    uint32_t desc[] = {static_cast<uint32_t>(tmap->eTexFormat),
+        tmap->u32MaxMapXSizeLg2, tmap->u32MaxMapYSizeLg2,
+        tmap->bMipMap ? 1u : 0u, tmap->clrTexChromaKey.r,
+        tmap->clrTexChromaKey.g, tmap->clrTexChromaKey.b};
+    uint64_t h = hash(0, desc, sizeof(desc));
+
+    if (tmap->eTexFormat == C3D_ETF_CI8) {
+        if (palette) {
+            auto& table = palette->table();
+            h = hash(h, &table[0], table.size() * sizeof(uint32_t));
+        } else {
+            h = hash(h, &tmap->htxpalTexPalette, sizeof(C3D_HTXPAL));
+        }
+    }
+
+    uint32_t width = 1 << tmap->u32MaxMapXSizeLg2;
+    uint32_t height = 1 << tmap->u32MaxMapYSizeLg2;
+
+    uint32_t levels = 1;
+    if (tmap->bMipMap) {
+        levels = std::max(tmap->u32MaxMapXSizeLg2, tmap->u32MaxMapYSizeLg2) + 1;
+    }
+
+    for (uint32_t level = 0; level < levels; level++) {
+        h = hash(h, tmap->apvLevels[level], width * height * texel);
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+
+    // zero is reserved for textures that can't be cached
+    return h != 0 ? h : 1;
+}
+
+std::shared_ptr<Texture> TextureCache::find(uint64_t key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+
+    auto texture = it->second.lock();
+    if (!texture) {
+        m_entries.erase(it);
+    }
+
+    return texture;
+}
+
+void TextureCache::insert(uint64_t key, std::shared_ptr<Texture> texture)
+{
+    // drop entries of released textures once in a while, so the map doesn't
+    // grow with every level the application loads
+    if (m_entries.size() >= m_pruneSize) {
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->second.expired()) {
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_pruneSize = std::max<size_t>(256, m_entries.size() * 2);
+    }
+
+    m_entries[key] = texture;
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Palette.hpp"
+#include "Texture.hpp"
+#include "ati3dcif.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace glrage {
+namespace cif {
+
+// Shares textures between handles that were registered with identical
+// content. Entries don't own their texture, it's released as soon as the last
+// handle using it is unregistered.
+class TextureCache
+{
+public:
+    static uint64_t key(C3D_PTMAP tmap, const Palette* palette);
+    std::shared_ptr<Texture> find(uint64_t key);
+    void insert(uint64_t key, std::shared_ptr<Texture> texture);
+
+private:
+    std::unordered_map<uint64_t, std::weak_ptr<Texture>> m_entries;
+    size_t m_pruneSize = 256;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
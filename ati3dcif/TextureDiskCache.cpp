@@ -0,0 +1,176 @@
+#include "TextureDiskCache.hpp"
+
+#include <glrage_util/ErrorUtils.hpp>
+#include <glrage_util/Logger.hpp>
+
+#include <Windows.h>
+
+#include <cstring>
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+// entries start on 16 byte boundaries, so the chains can be read with aligned
+// SIMD loads
+inline uint32_t align(size_t offset)
+{
+    return static_cast<uint32_t>((offset + 15) & ~size_t(15));
+}
+
+} // namespace
+
+TextureDiskCache::TextureDiskCache(const std::wstring& path, uint32_t capacity)
+{
+    m_file = CreateFile(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        m_file = nullptr;
+        LOG_INFO("Can't open texture cache: %s",
+            ErrorUtils::getWindowsErrorString().c_str());
+        return;
+    }
+
+    // never truncate a file created with a larger capacity
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(m_file, &fileSize) && fileSize.QuadPart > capacity &&
+        fileSize.QuadPart <= UINT32_MAX) {
+        capacity = static_cast<uint32_t>(fileSize.QuadPart);
+    }
+
+    // mapping the file extends it to the full capacity
+    m_mapping = CreateFileMapping(
+        m_file, nullptr, PAGE_READWRITE, 0, capacity, nullptr);
+    if (m_mapping) {
+        m_data = static_cast<uint8_t*>(
+            MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, capacity));
+    }
+
+    if (!m_data) {
+        LOG_INFO("Can't map texture cache: %s",
+            ErrorUtils::getWindowsErrorString().c_str());
+        close();
+        return;
+    }
+
+    m_capacity = capacity;
+    scan();
+
+    LOG_INFO("Texture cache contains %u entries",
+        static_cast<uint32_t>(m_index.size()));
+}
+
+TextureDiskCache::~TextureDiskCache()
+{
+    close();
+}
+
+bool TextureDiskCache::valid()
+{
+    return m_data != nullptr;
+}
+
+const uint8_t* TextureDiskCache::find(uint64_t key, size_t size)
+{
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return nullptr;
+    }
+
+    // a size mismatch means a hash collision
+    auto entry = reinterpret_cast<const Entry*>(m_data + it->second);
+    if (entry->size != size) {
+        return nullptr;
+    }
+
+    return m_data + it->second + sizeof(Entry);
+}
+
+void TextureDiskCache::insert(uint64_t key, const uint8_t* data, size_t size)
+{
+    if (!m_data || m_full || m_index.find(key) != m_index.end()) {
+        return;
+    }
+
+    auto header = reinterpret_cast<Header*>(m_data);
+    uint32_t offset = header->end;
+    size_t end = align(offset + sizeof(Entry) + size);
+    if (end > m_capacity) {
+        LOG_INFO("Texture cache is full");
+        m_full = true;
+        return;
+    }
+
+    auto entry = reinterpret_cast<Entry*>(m_data + offset);
+    entry->key = key;
+    entry->size = static_cast<uint32_t>(size);
+    entry->padding = 0;
+    std::memcpy(m_data + offset + sizeof(Entry), data, size);
+
+    // the header is updated last, so an interrupted write only loses the
+    // last entry
+    header->count++;
+    header->end = static_cast<uint32_t>(end);
+    m_index[key] = offset;
+}
+
+void TextureDiskCache::close()
+{
+    if (m_data) {
+        FlushViewOfFile(m_data, 0);
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+
+    if (m_file) {
+        CloseHandle(m_file);
+        m_file = nullptr;
+    }
+}
+
+void TextureDiskCache::reset()
+{
+    auto header = reinterpret_cast<Header*>(m_data);
+    header->magic = MAGIC;
+    header->version = VERSION;
+    header->count = 0;
+    header->end = align(sizeof(Header));
+    m_index.clear();
+}
+
+void TextureDiskCache::scan()
+{
+    auto header = reinterpret_cast<Header*>(m_data);
+    uint32_t offset = align(sizeof(Header));
+    if (header->magic != MAGIC || header->version != VERSION ||
+        header->end > m_capacity || header->end < offset) {
+        reset();
+        return;
+    }
+
+    for (uint32_t i = 0; i < header->count; i++) {
+        // sizes are compared with the remaining space, adding them to the
+        // offset could wrap around with a 32 bit size_t
+        uint32_t remaining = header->end - offset;
+        auto entry = reinterpret_cast<const Entry*>(m_data + offset);
+        if (remaining < sizeof(Entry) ||
+            entry->size > remaining - sizeof(Entry) ||
+            align(offset + sizeof(Entry) + entry->size) > header->end) {
+            LOG_INFO("Texture cache is damaged, starting over");
+            reset();
+            return;
+        }
+
+        m_index[entry->key] = offset;
+        offset = align(offset + sizeof(Entry) + entry->size);
+    }
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
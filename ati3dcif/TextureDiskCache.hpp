@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace glrage {
+namespace cif {
+
+// Memory mapped file of converted mipmap chains keyed by the content hash of
+// their texture maps, so textures loaded again in later sessions skip the
+// conversion. The file is allocated with a fixed capacity, entries are only
+// appended until it's full.
+class TextureDiskCache
+{
+public:
+    TextureDiskCache(const std::wstring& path, uint32_t capacity);
+    ~TextureDiskCache();
+    bool valid();
+    const uint8_t* find(uint64_t key, size_t size);
+    void insert(uint64_t key, const uint8_t* data, size_t size);
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t count;
+        uint32_t end;
+    };
+
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t size;
+        uint32_t padding;
+    };
+
+    static const uint32_t MAGIC = 0x43544c47; // "GLTC"
+
+    // must be increased if the hash or the conversion changes
+    static const uint32_t VERSION = 1;
+
+    void close();
+    void reset();
+    void scan();
+
+    // Windows handles, so the header doesn't need Windows.h
+    void* m_file{nullptr};
+    void* m_mapping{nullptr};
+    uint8_t* m_data{nullptr};
+    uint32_t m_capacity{0};
+    bool m_full{false};
+    std::unordered_map<uint64_t, uint32_t> m_index;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace glrage {
+namespace cif {
+
+// storage formats of texture arrays
+enum TextureFormat
+{
+    TEXTURE_RGBA8,  // all application formats, converted by the GL
+    TEXTURE_INDEX8, // palette indices, resolved in the shader
+    TEXTURE_BC1,    // DXT1 blocks, opaque or with 1 bit alpha
+    TEXTURE_BC3     // DXT5 blocks
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "TexturePool.hpp"
+
+namespace glrage {
+namespace cif {
+
+std::shared_ptr<TextureArray> TexturePool::acquire(
+    uint32_t width, uint32_t height, bool appMipmaps, TextureFormat format)
+{
+    // Arrays with generated mipmaps are kept apart from arrays with
+    // application mipmaps, since generating mipmaps overwrites all layers.
+    // Empty arrays are kept as well, applications tend to register textures of
+    // the same sizes again after releasing them.
+    for (auto& array : m_arrays) {
+        if (array->width() == width && array->height() == height &&
+            array->appMipmaps() == appMipmaps &&
+            array->format() == format && !array->full()) {
+            return array;
+        }
+    }
+
+    auto array =
+        std::make_shared<TextureArray>(width, height, appMipmaps, format);
+    m_arrays.push_back(array);
+    return array;
+}
+
+void TexturePool::update()
+{
+    for (auto& array : m_arrays) {
+        array->updateMipmaps();
+    }
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
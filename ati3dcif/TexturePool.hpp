@@ -0,0 +1,26 @@
+#pragma once
+
+#include "TextureArray.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace glrage {
+namespace cif {
+
+// Buckets texture arrays by size, mipmap source and format, so textures of the
+// same kind end up in as few arrays as possible.
+class TexturePool
+{
+public:
+    std::shared_ptr<TextureArray> acquire(
+        uint32_t width, uint32_t height, bool appMipmaps, TextureFormat format);
+    void update();
+
+private:
+    std::vector<std::shared_ptr<TextureArray>> m_arrays;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "TextureUploader.hpp"
+#include "Texture.hpp"
+
+namespace glrage {
+namespace cif {
+
+TextureUploader::TextureUploader(uint32_t budget)
+    : m_budget(budget)
+{
+}
+
+TextureUploader::StagingBuffer TextureUploader::acquire(size_t size)
+{
+    // pick the smallest free buffer that is large enough
+    auto best = m_free.end();
+    for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+        if (it->capacity >= size &&
+            (best == m_free.end() || it->capacity < best->capacity)) {
+            best = it;
+        }
+    }
+
+    StagingBuffer staging;
+    if (best != m_free.end()) {
+        staging = std::move(*best);
+        m_free.erase(best);
+    } else {
+        // round up, so buffers can be reused for textures of other sizes
+        staging.capacity = 4096;
+        while (staging.capacity < size) {
+            staging.capacity <<= 1;
+        }
+        staging.buffer = std::make_unique<gl::Buffer>(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    // orphan the previous storage, pending uploads from it may still be in
+    // flight
+    staging.buffer->bind();
+    staging.buffer->data(
+        static_cast<GLsizei>(staging.capacity), nullptr, GL_STREAM_DRAW);
+    return staging;
+}
+
+void TextureUploader::release(StagingBuffer staging)
+{
+    if (m_free.size() < MAX_FREE_BUFFERS) {
+        m_free.push_back(std::move(staging));
+    }
+}
+
+uint32_t TextureUploader::queue(std::shared_ptr<Texture> texture)
+{
+    if (m_budget == 0) {
+        return texture->upload(*this);
+    }
+
+    m_queue.push_back(texture);
+    return 0;
+}
+
+uint32_t TextureUploader::process()
+{
+    // at least one texture is uploaded per frame, even if it exceeds the
+    // budget on its own
+    uint32_t uploaded = 0;
+    while (!m_queue.empty() && uploaded < m_budget) {
+        auto texture = m_queue.front().lock();
+        m_queue.pop_front();
+
+        // the texture may have been unregistered or used already
+        if (texture && texture->pending()) {
+            uploaded += texture->upload(*this);
+        }
+    }
+
+    return uploaded;
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
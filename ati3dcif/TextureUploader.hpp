@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glrage_gl/Buffer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace glrage {
+namespace cif {
+
+class Texture;
+
+// Hands out pixel buffer objects for staging converted texture data and
+// spreads the uploads of queued textures over frames, so bursts of texture
+// registrations don't stall a single frame.
+class TextureUploader
+{
+public:
+    struct StagingBuffer
+    {
+        size_t capacity;
+        std::unique_ptr<gl::Buffer> buffer;
+    };
+
+    // zero budget uploads textures as soon as they are queued
+    TextureUploader(uint32_t budget);
+    StagingBuffer acquire(size_t size);
+    void release(StagingBuffer staging);
+    uint32_t queue(std::shared_ptr<Texture> texture);
+    uint32_t process();
+
+private:
+    static const size_t MAX_FREE_BUFFERS = 16;
+
+    uint32_t m_budget;
+    std::vector<StagingBuffer> m_free;
+    std::deque<std::weak_ptr<Texture>> m_queue;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
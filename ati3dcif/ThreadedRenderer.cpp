@@ -0,0 +1,302 @@
+#include "ThreadedRenderer.hpp"
+#include "Error.hpp"
+#include "Utils.hpp"
+#include "VertexConverter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+// bytes per texel of the supported texture formats
+uint32_t texelSize(C3D_ETEXFMT format)
+{
+    switch (format) {
+        case C3D_ETF_RGB1555:
+        case C3D_ETF_RGB565:
+        case C3D_ETF_RGB4444:
+            return 2;
+
+        case C3D_ETF_RGB332:
+        case C3D_ETF_CI8:
+            return 1;
+
+        default:
+            throw Error("Unsupported texture format: " +
+                            std::string(C3D_ETEXFMT_NAMES[format]),
+                C3D_EC_NOTIMPYET);
+    }
+}
+
+// application data copied into a command
+typedef std::shared_ptr<std::vector<uint8_t>> DataCopy;
+
+DataCopy copyData(const void* data, size_t size)
+{
+    auto src = static_cast<const uint8_t*>(data);
+    return std::make_shared<std::vector<uint8_t>>(src, src + size);
+}
+
+} // namespace
+
+ThreadedRenderer::ThreadedRenderer()
+{
+    // GL objects must be created by the thread that owns the context
+    m_renderThread.call([this] { m_renderer = std::make_unique<Renderer>(); });
+}
+
+ThreadedRenderer::~ThreadedRenderer()
+{
+    m_renderThread.call([this] { m_renderer.reset(); });
+}
+
+void ThreadedRenderer::renderBegin(C3D_HRC hRC)
+{
+    m_renderThread.post([this, hRC] { m_renderer->renderBegin(hRC); });
+}
+
+void ThreadedRenderer::renderEnd()
+{
+    m_renderThread.post([this] { m_renderer->renderEnd(); });
+}
+
+void ThreadedRenderer::textureReg(C3D_PTMAP ptmapToReg, C3D_PHTX phtmap)
+{
+    // create new texture handle, zero is reserved for "no texture"
+    auto htx = reinterpret_cast<C3D_HTX>(++m_textureID);
+
+    if (!m_renderThread.active()) {
+        m_renderer->textureReg(ptmapToReg, htx);
+        m_textures.insert(htx);
+        *phtmap = htx;
+        return;
+    }
+
+    // older versions of the SDK have a shorter struct
+    C3D_TMAP tmap{};
+    memcpy(&tmap, ptmapToReg,
+        std::min<size_t>(ptmapToReg->u32Size, sizeof(C3D_TMAP)));
+
+    // errors of queued commands can't be reported, so the palette is checked
+    // before the texture is queued
+    if (tmap.eTexFormat == C3D_ETF_CI8 &&
+        m_palettes.find(tmap.htxpalTexPalette) == m_palettes.end()) {
+        throw Error("Invalid palette handle", C3D_EC_BADPARAM);
+    }
+
+    uint32_t levels = 1;
+    if (tmap.bMipMap) {
+        levels = std::max(tmap.u32MaxMapXSizeLg2, tmap.u32MaxMapYSizeLg2) + 1;
+    }
+
+    // copy all levels into one block
+    uint32_t width = 1 << tmap.u32MaxMapXSizeLg2;
+    uint32_t height = 1 << tmap.u32MaxMapYSizeLg2;
+    uint32_t bpp = texelSize(tmap.eTexFormat);
+    std::vector<size_t> offsets;
+    auto data = std::make_shared<std::vector<uint8_t>>();
+
+    for (uint32_t level = 0; level < levels; level++) {
+        auto src = static_cast<const uint8_t*>(tmap.apvLevels[level]);
+        offsets.push_back(data->size());
+        data->insert(data->end(), src, src + width * height * bpp);
+
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+
+    m_renderThread.post([this, tmap, htx, offsets, data]() mutable {
+        for (size_t level = 0; level < offsets.size(); level++) {
+            tmap.apvLevels[level] = &(*data)[offsets[level]];
+        }
+        m_renderer->textureReg(&tmap, htx);
+    });
+
+    m_textures.insert(htx);
+    *phtmap = htx;
+}
+
+void ThreadedRenderer::textureUnreg(C3D_HTX htxToUnreg)
+{
+    if (m_textures.erase(htxToUnreg) == 0) {
+        throw Error("Invalid texture handle", C3D_EC_BADPARAM);
+    }
+
+    // the renderer unbinds the texture as well
+    if (htxToUnreg == m_state.get(C3D_ERS_TMAP_SELECT).htx) {
+        m_state.set(C3D_ERS_TMAP_SELECT, StateVar::Value{0});
+    }
+
+    m_renderThread.post(
+        [this, htxToUnreg] { m_renderer->textureUnreg(htxToUnreg); });
+}
+
+void ThreadedRenderer::texturePaletteCreate(
+    C3D_ECI_TMAP_TYPE epalette, void* pPalette, C3D_PHTXPAL phtpalCreated)
+{
+    if (epalette != C3D_ECI_TMAP_8BIT) {
+        throw Error("Unsupported palette type: " +
+                        std::string(C3D_ECI_TMAP_TYPE_NAMES[epalette]),
+            C3D_EC_NOTIMPYET);
+    }
+
+    // create new palette handle
+    auto htxpal = reinterpret_cast<C3D_HTXPAL>(m_paletteID++);
+    m_palettes.insert(htxpal);
+
+    auto palette = copyData(pPalette, sizeof(C3D_PALETTENTRY) * 256);
+    m_renderThread.post([this, epalette, palette, htxpal] {
+        m_renderer->texturePaletteCreate(epalette, &(*palette)[0], htxpal);
+    });
+
+    *phtpalCreated = htxpal;
+}
+
+void ThreadedRenderer::texturePaletteDestroy(C3D_HTXPAL htxpalToDestroy)
+{
+    m_palettes.erase(htxpalToDestroy);
+    m_renderThread.post([this, htxpalToDestroy] {
+        m_renderer->texturePaletteDestroy(htxpalToDestroy);
+    });
+}
+
+void ThreadedRenderer::texturePaletteAnimate(C3D_HTXPAL htxpalToAnimate,
+    C3D_UINT32 u32StartIndex, C3D_UINT32 u32NumEntries,
+    C3D_PPALETTENTRY pclrPalette)
+{
+    m_renderThread.call([&] {
+        m_renderer->texturePaletteAnimate(
+            htxpalToAnimate, u32StartIndex, u32NumEntries, pclrPalette);
+    });
+}
+
+void ThreadedRenderer::renderPrimStrip(C3D_VSTRIP vStrip, C3D_UINT32 u32NumVert)
+{
+    m_context.setRendered();
+
+    if (!m_renderThread.active()) {
+        m_renderer->renderPrimStrip(vStrip, u32NumVert);
+        return;
+    }
+
+    if (u32NumVert == 0) {
+        return;
+    }
+
+    auto vertices = copyData(vStrip, vertexSize() * u32NumVert);
+    m_renderThread.post([this, vertices, u32NumVert] {
+        m_renderer->renderPrimStrip(&(*vertices)[0], u32NumVert);
+    });
+}
+
+void ThreadedRenderer::renderPrimList(C3D_VLIST vList, C3D_UINT32 u32NumVert)
+{
+    m_context.setRendered();
+
+    if (!m_renderThread.active()) {
+        m_renderer->renderPrimList(vList, u32NumVert);
+        return;
+    }
+
+    if (u32NumVert == 0) {
+        return;
+    }
+
+    // gather the vertices, the pointers are rebuilt by the render thread
+    size_t size = vertexSize();
+    auto vertices = std::make_shared<std::vector<uint8_t>>(size * u32NumVert);
+    for (C3D_UINT32 i = 0; i < u32NumVert; i++) {
+        memcpy(&(*vertices)[i * size], vList[i], size);
+    }
+
+    m_renderThread.post([this, vertices, size, u32NumVert] {
+        std::vector<void*> list(u32NumVert);
+        for (C3D_UINT32 i = 0; i < u32NumVert; i++) {
+            list[i] = &(*vertices)[i * size];
+        }
+        m_renderer->renderPrimList(&list[0], u32NumVert);
+    });
+}
+
+void ThreadedRenderer::renderPrimMesh(
+    C3D_PVARRAY vMesh, C3D_PUINT32 pu32Indicies, C3D_UINT32 u32NumIndicies)
+{
+    m_context.setRendered();
+
+    if (!m_renderThread.active()) {
+        m_renderer->renderPrimMesh(vMesh, pu32Indicies, u32NumIndicies);
+        return;
+    }
+
+    if (u32NumIndicies == 0) {
+        return;
+    }
+
+    // copy the referenced range of the vertex array and rebase the indices
+    // onto it
+    auto range =
+        std::minmax_element(pu32Indicies, pu32Indicies + u32NumIndicies);
+    uint32_t first = *range.first;
+    uint32_t count = *range.second - first + 1;
+
+    size_t size = vertexSize();
+    auto vertices = copyData(
+        static_cast<const uint8_t*>(vMesh) + first * size, count * size);
+
+    auto indices = std::make_shared<std::vector<C3D_UINT32>>(
+        pu32Indicies, pu32Indicies + u32NumIndicies);
+    for (auto& index : *indices) {
+        index -= first;
+    }
+
+    m_renderThread.post([this, vertices, indices] {
+        m_renderer->renderPrimMesh(&(*vertices)[0], &(*indices)[0],
+            static_cast<C3D_UINT32>(indices->size()));
+    });
+}
+
+void ThreadedRenderer::setState(C3D_ERSID eRStateID, C3D_PRSDATA pRStateData)
+{
+    if (static_cast<uint32_t>(eRStateID) >= C3D_ERS_NUM) {
+        throw Error("Invalid render state", C3D_EC_BADPARAM);
+    }
+
+    // errors of queued commands can't be reported, so selected textures are
+    // checked before the state is changed
+    if (eRStateID == C3D_ERS_TMAP_SELECT) {
+        auto htx = *static_cast<C3D_HTX*>(pRStateData);
+        if (htx != 0 && m_textures.find(htx) == m_textures.end()) {
+            throw Error("Invalid texture handle", C3D_EC_BADPARAM);
+        }
+    }
+
+    // the state data is copied by value, which also filters redundant changes
+    if (!m_state.set(eRStateID, pRStateData)) {
+        return;
+    }
+
+    StateVar::Value value = m_state.get(eRStateID);
+    m_renderThread.post(
+        [this, eRStateID, value] { m_renderer->setState(eRStateID, value); });
+}
+
+FrameStats ThreadedRenderer::stats()
+{
+    // the counters are updated by the render thread at the end of each frame
+    FrameStats stats;
+    m_renderThread.call([this, &stats] { stats = m_renderer->stats(); });
+    return stats;
+}
+
+size_t ThreadedRenderer::vertexSize()
+{
+    return vertexConverter(m_state.get(C3D_ERS_VERTEX_TYPE).evertex).size;
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Renderer.hpp"
+#include "State.hpp"
+
+#include <glrage/GLRage.hpp>
+#include <glrage_util/RenderThread.hpp>
+
+#include <memory>
+#include <set>
+
+namespace glrage {
+namespace cif {
+
+// Front end of the renderer for the CIF entry points. If the render thread is
+// running, calls are recorded as commands with copies of all application data
+// they reference and the renderer is only ever used by the render thread.
+// Otherwise, calls are forwarded directly. Handles are assigned here, so
+// registration doesn't need to wait for the render thread.
+class ThreadedRenderer
+{
+public:
+    ThreadedRenderer();
+    ~ThreadedRenderer();
+    void renderBegin(C3D_HRC);
+    void renderEnd();
+    void textureReg(C3D_PTMAP, C3D_PHTX);
+    void textureUnreg(C3D_HTX);
+    void texturePaletteCreate(C3D_ECI_TMAP_TYPE, void*, C3D_PHTXPAL);
+    void texturePaletteDestroy(C3D_HTXPAL);
+    void texturePaletteAnimate(
+        C3D_HTXPAL, C3D_UINT32, C3D_UINT32, C3D_PPALETTENTRY);
+    void renderPrimStrip(C3D_VSTRIP, C3D_UINT32);
+    void renderPrimList(C3D_VLIST, C3D_UINT32);
+    void renderPrimMesh(C3D_PVARRAY, C3D_PUINT32, C3D_UINT32);
+    void setState(C3D_ERSID eRStateID, C3D_PRSDATA pRStateData);
+    FrameStats stats();
+
+private:
+    size_t vertexSize();
+
+    Context& m_context{GLRage::getContext()};
+    RenderThread& m_renderThread{GLRage::getRenderThread()};
+    std::unique_ptr<Renderer> m_renderer;
+    int32_t m_textureID{0};
+    int32_t m_paletteID{0};
+
+    // handles of the existing textures and palettes, so commands can be
+    // checked before they're queued
+    std::set<C3D_HTX> m_textures;
+    std::set<C3D_HTXPAL> m_palettes;
+
+    // copy of the render states, which are required to size vertex data and
+    // allow redundant state changes to be dropped before they're queued
+    State m_state;
+};
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+#include <emmintrin.h>
+
+namespace glrage {
+namespace cif {
+
+// Converts four consecutive float color components in the range 0-255 to
+// RGBA8. Values are rounded to the nearest integer, with ties to even, and
+// clamped by the saturating packs.
+inline uint32_t packColor(const float* rgba)
+{
+    __m128i v = _mm_cvtps_epi32(_mm_loadu_ps(rgba));
+    v = _mm_packs_epi32(v, v);
+    v = _mm_packus_epi16(v, v);
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+// converts colors packed as ARGB to RGBA8, so only red and blue are swapped
+inline uint32_t swizzleColor(uint32_t argb)
+{
+    return (argb & 0xff00ff00) | ((argb >> 16) & 0xff) | ((argb & 0xff) << 16);
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "VertexConverter.hpp"
+#include "Error.hpp"
+#include "VertexColor.hpp"
+
+#include <string>
+
+namespace glrage {
+namespace cif {
+
+namespace {
+
+// layout of C3D_TLVERTEX, which mirrors D3DTLVERTEX
+struct TLVertex
+{
+    float sx, sy, sz, rhw;
+    uint32_t color;
+    uint32_t specular;
+    float tu, tv;
+};
+
+static_assert(sizeof(TLVertex) == sizeof(C3D_TLVERTEX),
+    "TLVertex must match the layout of C3D_TLVERTEX");
+
+const uint32_t COLOR_WHITE = 0xffffffff;
+
+// Each vertex type gets its own specialization, so the conversion loops don't
+// need to check which attributes are present. Missing colors default to
+// white and missing texture coordinates to zero.
+template <typename T> void convertVertex(const T& src, Vertex& dst);
+
+template <> inline void convertVertex(const C3D_VF& src, Vertex& dst)
+{
+    dst.x = src.x;
+    dst.y = src.y;
+    dst.z = src.z;
+    dst.s = 0;
+    dst.t = 0;
+    dst.w = 1;
+    dst.color = COLOR_WHITE;
+}
+
+template <> inline void convertVertex(const C3D_VCF& src, Vertex& dst)
+{
+    dst.x = src.x;
+    dst.y = src.y;
+    dst.z = src.z;
+    dst.s = 0;
+    dst.t = 0;
+    dst.w = 1;
+    dst.color = packColor(&src.r);
+}
+
+template <> inline void convertVertex(const C3D_VTF& src, Vertex& dst)
+{
+    dst.x = src.x;
+    dst.y = src.y;
+    dst.z = src.z;
+    dst.s = src.s;
+    dst.t = src.t;
+    dst.w = src.w;
+    dst.color = COLOR_WHITE;
+}
+
+template <> inline void convertVertex(const C3D_VTCF& src, Vertex& dst)
+{
+    dst.x = src.x;
+    dst.y = src.y;
+    dst.z = src.z;
+    dst.s = src.s;
+    dst.t = src.t;
+    dst.w = src.w;
+    dst.color = packColor(&src.r);
+}
+
+template <> inline void convertVertex(const TLVertex& src, Vertex& dst)
+{
+    dst.x = src.sx;
+    dst.y = src.sy;
+    dst.z = src.sz;
+
+    // texture coordinates are divided by w in the shader like the ones of the
+    // CIF vertex types
+    dst.s = src.tu * src.rhw;
+    dst.t = src.tv * src.rhw;
+    dst.w = src.rhw;
+
+    dst.color = swizzleColor(src.color);
+}
+
+template <typename T>
+void convertVertices(const uint8_t* src, size_t stride, size_t numVert,
+    uint32_t material, Vertex* dst)
+{
+    for (size_t i = 0; i < numVert; i++) {
+        convertVertex(*reinterpret_cast<const T*>(src + i * stride), dst[i]);
+        dst[i].material = material;
+    }
+}
+
+// indexed by C3D_EVERTEX
+const VertexConverter VERTEX_CONVERTERS[] = {
+    {sizeof(C3D_VF), convertVertices<C3D_VF>},
+    {sizeof(C3D_VCF), convertVertices<C3D_VCF>},
+    {sizeof(C3D_VTF), convertVertices<C3D_VTF>},
+    {sizeof(C3D_VTCF), convertVertices<C3D_VTCF>},
+    {sizeof(TLVertex), convertVertices<TLVertex>},
+};
+
+} // namespace
+
+const VertexConverter& vertexConverter(C3D_EVERTEX vertexType)
+{
+    if (static_cast<uint32_t>(vertexType) >= C3D_EV_NUM) {
+        throw Error("Invalid vertex type: " + std::to_string(vertexType),
+            C3D_EC_BADPARAM);
+    }
+
+    return VERTEX_CONVERTERS[vertexType];
+}
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ati3dcif.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace glrage {
+namespace cif {
+
+// vertex as stored in the vertex buffer, all C3D vertex types are converted to
+// this format, so they can be mixed freely within a batch
+struct Vertex
+{
+    float x, y, z;
+    float s, t, w;
+    uint32_t color; // RGBA8
+    uint32_t material;
+};
+
+static_assert(sizeof(Vertex) == 32, "Vertex must be tightly packed");
+
+// converts a number of application vertices of a specific type, which are
+// stride bytes apart
+typedef void (*VertexConvertFunc)(const uint8_t* src, size_t stride,
+    size_t numVert, uint32_t material, Vertex* dst);
+
+struct VertexConverter
+{
+    size_t size;
+    VertexConvertFunc convert;
+};
+
+const VertexConverter& vertexConverter(C3D_EVERTEX vertexType);
+
+} // namespace cif
+} // namespace glrage
\ No newline at end of file
@@ -1,123 +1,214 @@
 #include "VertexStream.hpp"
-#include "Error.hpp"
-#include "Utils.hpp"
+#include "Indices.hpp"
 
 #include <glrage_gl/Utils.hpp>
 #include <glrage_util/Logger.hpp>
 
+#include <algorithm>
+#include <limits>
+
 namespace glrage {
 namespace cif {
 
 VertexStream::VertexStream()
-    : m_vertexBuffer(GL_ARRAY_BUFFER)
+    : m_vertexBuffer(
+          GL_ARRAY_BUFFER, VERTEX_BUFFER_SEGMENT_SIZE, BUFFER_SEGMENTS)
+    , m_indexBuffer(
+          GL_ELEMENT_ARRAY_BUFFER, INDEX_BUFFER_SEGMENT_SIZE, BUFFER_SEGMENTS)
+    , m_stripIndices{0, 1, 2}
+    , m_quadStripIndices{0, 1, 2, 1, 3, 2}
 {
     // bind vertex buffer
     m_vertexBuffer.bind();
 
     // define vertex formats
     m_vtcFormat.bind();
-    m_vtcFormat.attribute(0, 3, GL_FLOAT, GL_FALSE, 40, 0);
-    m_vtcFormat.attribute(1, 3, GL_FLOAT, GL_FALSE, 40, 12);
-    m_vtcFormat.attribute(2, 4, GL_FLOAT, GL_FALSE, 40, 24);
+    m_vtcFormat.attribute(0, 3, GL_FLOAT, GL_FALSE, 32, 0);
+    m_vtcFormat.attribute(1, 3, GL_FLOAT, GL_FALSE, 32, 12);
+    m_vtcFormat.attribute(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, 32, 24);
+    m_vtcFormat.attributeInteger(3, 1, GL_UNSIGNED_INT, 32, 28);
 
     gl::Utils::checkError(__FUNCTION__);
 }
 
 void VertexStream::addPrimStrip(C3D_VSTRIP vertStrip, C3D_UINT32 numVert)
 {
-    // note: strips are converted to lists, since they can't be properly batched
-    // otherwise
-    switch (m_vertexType) {
-        case C3D_EV_VTCF: {
-            auto vStripVtcf = reinterpret_cast<C3D_VTCF*>(vertStrip);
-
-            if (m_primType == C3D_EPRIM_QUAD) {
-                // TODO: triangulate quads
-            } else {
-                for (C3D_UINT32 i = 0; i < numVert; i++) {
-                    if (i > 2) {
-                        m_vtcBuffer.push_back(vStripVtcf[i - 2]);
-                        m_vtcBuffer.push_back(vStripVtcf[i - 1]);
-                    }
-                    m_vtcBuffer.push_back(vStripVtcf[i]);
-                }
-            }
-
-            break;
-        }
+    // note: strips are converted to indexed lists, since they can't be properly
+    // batched otherwise
+
+    // copy each vertex only once and let the indices do the rest
+    auto base = static_cast<uint32_t>(m_vtxBuffer.size());
+    addVertices(vertStrip, numVert);
 
-        default:
-            throw Error("Unsupported vertex type: " +
-                               std::string(C3D_EVERTEX_NAMES[m_vertexType]),
-                C3D_EC_NOTIMPYET);
+    if (m_primType == C3D_EPRIM_QUAD) {
+        // each quad shares two vertices with the previous one
+        auto& indices = quadStripIndices(numVert);
+        size_t numIndices = numVert > 3 ? (numVert - 2) / 2 * 6 : 0;
+        addIndices(&indices[0], numIndices, base);
+    } else {
+        auto& indices = stripIndices(numVert);
+        size_t numIndices = numVert > 2 ? (numVert - 2) * 3 : numVert;
+        addIndices(&indices[0], numIndices, base);
     }
 }
 
 void VertexStream::addPrimList(C3D_VLIST vertList, C3D_UINT32 numVert)
 {
-    switch (m_vertexType) {
-        case C3D_EV_VTCF: {
-            // copy vertices to vertex vector buffer, then to the vertex buffer
-            // (OpenGL can't handle arrays of pointers)
-            auto vListVtcf = reinterpret_cast<C3D_VTCF**>(vertList);
-
-            if (m_primType == C3D_EPRIM_QUAD) {
-                // triangulate quads
-                for (C3D_UINT32 i = 0; i < numVert; i += 4) {
-                    m_vtcBuffer.push_back(*vListVtcf[i + 0]);
-                    m_vtcBuffer.push_back(*vListVtcf[i + 1]);
-                    m_vtcBuffer.push_back(*vListVtcf[i + 3]);
-
-                    m_vtcBuffer.push_back(*vListVtcf[i + 1]);
-                    m_vtcBuffer.push_back(*vListVtcf[i + 2]);
-                    m_vtcBuffer.push_back(*vListVtcf[i + 3]);
-                }
-            } else {
-                // direct copy
-                for (C3D_UINT32 i = 0; i < numVert; i++) {
-                    m_vtcBuffer.push_back(*vListVtcf[i]);
-                }
-            }
-            break;
-        }
+    // copy vertices to vertex vector buffer, then to the vertex buffer
+    // (OpenGL can't handle arrays of pointers)
+    auto vList = reinterpret_cast<void**>(vertList);
+
+    // Vertices are often referenced more than once per list, so copy each one
+    // only once. Pointers are only compared within the same call, since the
+    // application is free to change the vertex data between calls.
+    resetVertexRefs(numVert);
+
+    if (m_primType == C3D_EPRIM_QUAD) {
+        // triangulate quads
+        for (C3D_UINT32 i = 0; i + 3 < numVert; i += 4) {
+            uint32_t v0 = addVertexRef(vList[i + 0]);
+            uint32_t v1 = addVertexRef(vList[i + 1]);
+            uint32_t v2 = addVertexRef(vList[i + 2]);
+            uint32_t v3 = addVertexRef(vList[i + 3]);
 
-        default:
-            throw Error("Unsupported vertex type: " +
-                               std::string(C3D_EVERTEX_NAMES[m_vertexType]),
-                C3D_EC_NOTIMPYET);
+            m_idxBuffer.push_back(v0);
+            m_idxBuffer.push_back(v1);
+            m_idxBuffer.push_back(v3);
+
+            m_idxBuffer.push_back(v1);
+            m_idxBuffer.push_back(v2);
+            m_idxBuffer.push_back(v3);
+        }
+    } else {
+        for (C3D_UINT32 i = 0; i < numVert; i++) {
+            m_idxBuffer.push_back(addVertexRef(vList[i]));
+        }
     }
+
+    m_listVertexCount += numVert;
 }
 
-void VertexStream::renderPending()
+void VertexStream::addPrimMesh(
+    C3D_PVARRAY vertArray, C3D_PUINT32 indices, C3D_UINT32 numIndices)
 {
-    // only render if there's something to render
-    if (m_vtcBuffer.empty()) {
+    if (numIndices == 0) {
         return;
     }
 
+    // copy the referenced range of the vertex array once
+    auto range = std::minmax_element(indices, indices + numIndices);
+    uint32_t first = *range.first;
+    uint32_t last = *range.second;
+
+    auto base = static_cast<uint32_t>(m_vtxBuffer.size());
+    auto vArray = static_cast<const uint8_t*>(vertArray);
+    addVertices(vArray + first * m_converter->size, last - first + 1);
+
+    // rebase the application's indices onto the batch
+    uint32_t offset = base - first;
+    if (m_primType == C3D_EPRIM_QUAD) {
+        // triangulate quads
+        for (C3D_UINT32 i = 0; i + 3 < numIndices; i += 4) {
+            m_idxBuffer.push_back(indices[i + 0] + offset);
+            m_idxBuffer.push_back(indices[i + 1] + offset);
+            m_idxBuffer.push_back(indices[i + 3] + offset);
+
+            m_idxBuffer.push_back(indices[i + 1] + offset);
+            m_idxBuffer.push_back(indices[i + 2] + offset);
+            m_idxBuffer.push_back(indices[i + 3] + offset);
+        }
+    } else {
+        addIndices(indices, numIndices, offset);
+    }
+}
+
+uint32_t VertexStream::vertexCount()
+{
+    return static_cast<uint32_t>(m_vtxBuffer.size());
+}
+
+uint32_t VertexStream::indexCount()
+{
+    return static_cast<uint32_t>(m_idxBuffer.size());
+}
+
+GLsizeiptr VertexStream::upload(std::vector<DrawCommand>& commands)
+{
+    // only upload if there's something to render
+    if (m_idxBuffer.empty()) {
+        return 0;
+    }
+
     // bind vertex format
     m_vtcFormat.bind();
 
-    // resize GPU buffer if required
-    size_t vertexBufferSize = sizeof(C3D_VTCF) * m_vtcBuffer.size();
-    if (vertexBufferSize > m_vertexBufferSize) {
-        LOG_INFO("Vertex buffer resize: %d -> %d", m_vertexBufferSize,
-            vertexBufferSize);
-        m_vertexBuffer.data(vertexBufferSize, nullptr, GL_STREAM_DRAW);
-        m_vertexBufferSize = vertexBufferSize;
+    // upload vertices to a free section of the stream buffer, aligned to the
+    // vertex size so it can be addressed as the base vertex of the draw calls
+    GLsizeiptr vertexBufferSize = sizeof(Vertex) * m_vtxBuffer.size();
+    GLintptr vertexOffset = m_vertexBuffer.upload(
+        &m_vtxBuffer[0], vertexBufferSize, sizeof(Vertex));
+    m_baseVertex = static_cast<GLint>(vertexOffset / sizeof(Vertex));
+
+    // Upload indices in the order of the commands, so the index ranges of
+    // commands that end up next to each other can be merged. 16 bit indices
+    // are used whenever possible.
+    bool narrow = m_vtxBuffer.size() <= std::numeric_limits<uint16_t>::max();
+    if (narrow) {
+        m_idxBuffer16.resize(m_idxBuffer.size());
+    } else {
+        m_idxBuffer32.resize(m_idxBuffer.size());
     }
 
-    // upload vertices
-    m_vertexBuffer.subData(0, vertexBufferSize, &m_vtcBuffer[0]);
+    uint32_t position = 0;
+    for (auto& cmd : commands) {
+        if (narrow) {
+            narrowIndices(
+                &m_idxBuffer[cmd.first], cmd.count, &m_idxBuffer16[position]);
+        } else {
+            std::copy_n(&m_idxBuffer[cmd.first], cmd.count,
+                &m_idxBuffer32[position]);
+        }
+        cmd.first = position;
+        position += cmd.count;
+    }
 
-    // draw vertices
-    glDrawArrays(GLCIF_PRIM_MODES[m_primType], 0, m_vtcBuffer.size());
+    GLsizeiptr indexBufferSize;
+    if (narrow) {
+        m_indexType = GL_UNSIGNED_SHORT;
+        indexBufferSize = sizeof(uint16_t) * position;
+        m_indexOffset = m_indexBuffer.upload(
+            &m_idxBuffer16[0], indexBufferSize, sizeof(uint16_t));
+    } else {
+        m_indexType = GL_UNSIGNED_INT;
+        indexBufferSize = sizeof(uint32_t) * position;
+        m_indexOffset = m_indexBuffer.upload(
+            &m_idxBuffer32[0], indexBufferSize, sizeof(uint32_t));
+    }
 
-    // mark buffer as empty
-    m_vtcBuffer.clear();
+    // mark buffers as empty
+    m_vtxBuffer.clear();
+    m_idxBuffer.clear();
 
     // check for errors
     gl::Utils::checkError(__FUNCTION__);
+
+    return vertexBufferSize + indexBufferSize;
+}
+
+void VertexStream::draw(GLenum mode, uint32_t first, uint32_t count)
+{
+    GLsizeiptr indexSize =
+        m_indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    auto indices = reinterpret_cast<void*>(m_indexOffset + first * indexSize);
+
+    m_vtcFormat.bind();
+    glDrawElementsBaseVertex(mode, count, m_indexType, indices, m_baseVertex);
+}
+
+void VertexStream::fence()
+{
+    m_vertexBuffer.fence();
+    m_indexBuffer.fence();
 }
 
 C3D_EVERTEX VertexStream::vertexType()
@@ -137,13 +228,143 @@ void VertexStream::primType(C3D_EPRIM primType)
 
 void VertexStream::vertexType(C3D_EVERTEX vertexType)
 {
+    // all vertex types are converted to the same format, so switching only
+    // selects another converter
+    m_converter = &vertexConverter(vertexType);
     m_vertexType = vertexType;
 }
 
+void VertexStream::material(uint32_t material)
+{
+    m_material = material;
+}
+
 void VertexStream::bind()
 {
     m_vertexBuffer.bind();
 }
 
+uint32_t VertexStream::wrapCount()
+{
+    return m_vertexBuffer.wrapCount() + m_indexBuffer.wrapCount();
+}
+
+uint32_t VertexStream::waitCount()
+{
+    return m_vertexBuffer.waitCount() + m_indexBuffer.waitCount();
+}
+
+uint32_t VertexStream::listVertexCount()
+{
+    return m_listVertexCount;
+}
+
+uint32_t VertexStream::listVertexCopies()
+{
+    return m_listVertexCopies;
+}
+
+const std::vector<uint32_t>& VertexStream::stripIndices(C3D_UINT32 numVert)
+{
+    // The triangle list indices of a shorter strip are always a prefix of the
+    // indices of a longer strip, so a single cached list is sufficient for all
+    // strip lengths. It only needs to be extended for longer strips.
+    for (auto i = static_cast<uint32_t>(m_stripIndices.size() / 3 + 2);
+         i < numVert; i++) {
+        if (i > 2) {
+            m_stripIndices.push_back(i - 2);
+            m_stripIndices.push_back(i - 1);
+        }
+        m_stripIndices.push_back(i);
+    }
+
+    return m_stripIndices;
+}
+
+const std::vector<uint32_t>& VertexStream::quadStripIndices(
+    C3D_UINT32 numVert)
+{
+    // Quad k of a strip consists of the vertices 2k, 2k+1, 2k+3 and 2k+2 in
+    // that order and is split like quads in lists. Like the triangle strip
+    // indices, shorter strips use a prefix of the cached list.
+    for (auto i = static_cast<uint32_t>(m_quadStripIndices.size() / 3 + 2);
+         i + 1 < numVert; i += 2) {
+        m_quadStripIndices.push_back(i - 2);
+        m_quadStripIndices.push_back(i - 1);
+        m_quadStripIndices.push_back(i);
+
+        m_quadStripIndices.push_back(i - 1);
+        m_quadStripIndices.push_back(i + 1);
+        m_quadStripIndices.push_back(i);
+    }
+
+    return m_quadStripIndices;
+}
+
+void VertexStream::addVertices(const void* vertices, size_t numVert)
+{
+    if (numVert == 0) {
+        return;
+    }
+
+    size_t offset = m_vtxBuffer.size();
+    m_vtxBuffer.resize(offset + numVert);
+
+    m_converter->convert(static_cast<const uint8_t*>(vertices),
+        m_converter->size, numVert, m_material, &m_vtxBuffer[offset]);
+}
+
+void VertexStream::addIndices(
+    const uint32_t* indices, size_t numIndices, uint32_t base)
+{
+    size_t offset = m_idxBuffer.size();
+    m_idxBuffer.resize(offset + numIndices);
+    rebaseIndices(indices, numIndices, base, &m_idxBuffer[offset]);
+}
+
+void VertexStream::resetVertexRefs(C3D_UINT32 numVert)
+{
+    // keep the table at most half full to keep the probe sequences short
+    size_t size = m_vertexRefs.empty() ? VERTEX_REFS_MIN_SIZE
+                                       : m_vertexRefs.size();
+    while (size < numVert * 2) {
+        size *= 2;
+    }
+
+    // entries from previous calls are invalidated by changing the tag, so the
+    // table only needs to be cleared if it is resized or the tag overflows
+    m_vertexRefTag++;
+    if (size != m_vertexRefs.size() || m_vertexRefTag == 0) {
+        m_vertexRefs.assign(size, VertexRef{nullptr, 0, 0});
+        m_vertexRefTag = 1;
+    }
+}
+
+uint32_t VertexStream::addVertexRef(const void* vertex)
+{
+    // multiplicative hash of the pointer, the lower bits are always zero due
+    // to the alignment of the vertex data
+    size_t mask = m_vertexRefs.size() - 1;
+    size_t slot =
+        ((reinterpret_cast<uintptr_t>(vertex) >> 2) * 2654435761u) & mask;
+
+    // linear probing until either the vertex or a free slot is found
+    while (m_vertexRefs[slot].tag == m_vertexRefTag) {
+        if (m_vertexRefs[slot].ptr == vertex) {
+            return m_vertexRefs[slot].index;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    auto index = static_cast<uint32_t>(m_vtxBuffer.size());
+    m_vtxBuffer.emplace_back();
+    m_converter->convert(static_cast<const uint8_t*>(vertex),
+        m_converter->size, 1, m_material, &m_vtxBuffer.back());
+    m_vertexRefs[slot] = VertexRef{vertex, index, m_vertexRefTag};
+    m_listVertexCopies++;
+
+    return index;
+}
+
 } // namespace cif
 } // namespace glrage
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
 
+#include "CommandBuffer.hpp"
+#include "VertexConverter.hpp"
 #include "ati3dcif.hpp"
 
+#include <glrage_gl/StreamBuffer.hpp>
 #include <glrage_gl/VertexArray.hpp>
-#include <glrage_gl/Buffer.hpp>
 
 #include <vector>
 
@@ -24,20 +26,66 @@ public:
     VertexStream();
     void addPrimStrip(C3D_VSTRIP vertStrip, C3D_UINT32 numVert);
     void addPrimList(C3D_VLIST vertList, C3D_UINT32 numVert);
-    void renderPending();
+    void addPrimMesh(
+        C3D_PVARRAY vertArray, C3D_PUINT32 indices, C3D_UINT32 numIndices);
+    uint32_t vertexCount();
+    uint32_t indexCount();
+    GLsizeiptr upload(std::vector<DrawCommand>& commands);
+    void draw(GLenum mode, uint32_t first, uint32_t count);
+    void fence();
     C3D_EVERTEX vertexType();
     void vertexType(C3D_EVERTEX vertexType);
     C3D_EPRIM primType();
     void primType(C3D_EPRIM primType);
+    void material(uint32_t material);
     void bind();
+    uint32_t wrapCount();
+    uint32_t waitCount();
+    uint32_t listVertexCount();
+    uint32_t listVertexCopies();
 
 private:
+    static const GLsizeiptr VERTEX_BUFFER_SEGMENT_SIZE = 1 << 20;
+    static const GLsizeiptr INDEX_BUFFER_SEGMENT_SIZE = 1 << 18;
+    static const uint32_t BUFFER_SEGMENTS = 4;
+    static const size_t VERTEX_REFS_MIN_SIZE = 256;
+
+    // entry of the open addressing table that maps application vertex
+    // pointers to indices in the vertex buffer
+    struct VertexRef
+    {
+        const void* ptr;
+        uint32_t index;
+        uint32_t tag;
+    };
+
+    const std::vector<uint32_t>& stripIndices(C3D_UINT32 numVert);
+    const std::vector<uint32_t>& quadStripIndices(C3D_UINT32 numVert);
+    void addVertices(const void* vertices, size_t numVert);
+    void addIndices(const uint32_t* indices, size_t numIndices, uint32_t base);
+    void resetVertexRefs(C3D_UINT32 numVert);
+    uint32_t addVertexRef(const void* vertex);
+
     C3D_EVERTEX m_vertexType;
+    const VertexConverter* m_converter = nullptr;
     C3D_EPRIM m_primType;
-    size_t m_vertexBufferSize = 0;
-    gl::Buffer m_vertexBuffer;
+    uint32_t m_material = 0;
     gl::VertexArray m_vtcFormat;
-    std::vector<C3D_VTCF> m_vtcBuffer;
+    gl::StreamBuffer m_vertexBuffer;
+    gl::StreamBuffer m_indexBuffer;
+    std::vector<Vertex> m_vtxBuffer;
+    std::vector<uint32_t> m_idxBuffer;
+    std::vector<uint32_t> m_idxBuffer32;
+    std::vector<uint16_t> m_idxBuffer16;
+    GLint m_baseVertex = 0;
+    GLenum m_indexType = GL_UNSIGNED_SHORT;
+    GLintptr m_indexOffset = 0;
+    std::vector<uint32_t> m_stripIndices;
+    std::vector<uint32_t> m_quadStripIndices;
+    std::vector<VertexRef> m_vertexRefs;
+    uint32_t m_vertexRefTag = 0;
+    uint32_t m_listVertexCount = 0;
+    uint32_t m_listVertexCopies = 0;
 };
 
 } // namespace cif
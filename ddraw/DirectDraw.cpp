@@ -10,11 +10,17 @@ namespace ddraw {
 DirectDraw::DirectDraw()
 {
     LOG_TRACE("");
+
+    // GL objects must be created by the thread that owns the context
+    m_renderThread.call([this] { m_renderer = std::make_unique<Renderer>(); });
 }
 
 DirectDraw::~DirectDraw()
 {
     LOG_TRACE("");
+
+    m_renderThread.call([this] { m_renderer.reset(); });
+    m_context.stopRenderThread();
 }
 
 /*** IUnknown methods ***/
@@ -80,7 +86,7 @@ HRESULT WINAPI DirectDraw::CreateSurface(LPDDSURFACEDESC lpDDSurfaceDesc,
 {
     LOG_TRACE("");
 
-    *lplpDDSurface = new DirectDrawSurface(*this, m_renderer, lpDDSurfaceDesc);
+    *lplpDDSurface = new DirectDrawSurface(*this, *m_renderer, lpDDSurfaceDesc);
 
     return DD_OK;
 }
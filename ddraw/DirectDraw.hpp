@@ -7,6 +7,7 @@
 #include <glrage/GLRage.hpp>
 
 #include <cstdint>
+#include <memory>
 
 namespace glrage {
 namespace ddraw {
@@ -65,7 +66,8 @@ private:
     const uint32_t DEFAULT_REFRESH_RATE = 60;
 
     Context& m_context = GLRage::getContext();
-    Renderer m_renderer;
+    RenderThread& m_renderThread = GLRage::getRenderThread();
+    std::unique_ptr<Renderer> m_renderer;
     uint32_t m_width = DEFAULT_WIDTH;
     uint32_t m_height = DEFAULT_HEIGHT;
     uint32_t m_refreshRate = DEFAULT_REFRESH_RATE;
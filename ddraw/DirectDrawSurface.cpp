@@ -185,8 +185,10 @@ HRESULT WINAPI DirectDrawSurface::Blt(LPRECT lpDestRect,
             GLint height;
             std::vector<uint8_t> buffer;
 
-            gl::Screenshot::capture(buffer, width, height, depth, GL_BGRA,
-                GL_UNSIGNED_SHORT_1_5_5_5_REV);
+            m_renderThread.call([&] {
+                gl::Screenshot::capture(buffer, width, height, depth, GL_BGRA,
+                    GL_UNSIGNED_SHORT_1_5_5_5_REV);
+            });
 
             Blitter::Rect srcRect{0, height, width, 0};
 
@@ -102,6 +102,7 @@ public:
 
 private:
     Context& m_context = GLRage::getContext();
+    RenderThread& m_renderThread = GLRage::getRenderThread();
     DirectDraw& m_dd;
     Renderer& m_renderer;
     std::vector<uint8_t> m_buffer;
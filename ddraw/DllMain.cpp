@@ -18,11 +18,17 @@ HRESULT WINAPI DirectDrawCreate(
     context.init();
     context.attach();
 
+    // share the GL state shadow with the other modules
+    gl::StateCache::setCurrent(GLRage::getGLState());
+
     ErrorUtils::setHWnd(context.getHWnd());
 
+    context.startRenderThread();
+
     try {
         *lplpDD = new DirectDraw();
     } catch (const std::exception& ex) {
+        context.stopRenderThread();
         ErrorUtils::warning(ex);
         return DDERR_GENERIC;
     }
@@ -3,6 +3,8 @@
 #include <glrage_gl/Shader.hpp>
 #include <glrage_gl/Utils.hpp>
 
+#include <memory>
+
 namespace glrage {
 namespace ddraw {
 
@@ -36,13 +38,37 @@ Renderer::Renderer()
 }
 
 void Renderer::upload(DDSURFACEDESC& desc, std::vector<uint8_t>& data)
+{
+    uint32_t width = desc.dwWidth;
+    uint32_t height = desc.dwHeight;
+
+    if (!m_renderThread.active()) {
+        uploadSurface(width, height, data);
+        return;
+    }
+
+    // the application may write to the surface again before the upload has
+    // been executed, so the render thread gets a copy
+    auto copy = std::make_shared<std::vector<uint8_t>>(data);
+    m_renderThread.post([this, width, height, copy] {
+        uploadSurface(width, height, *copy);
+    });
+}
+
+void Renderer::render()
+{
+    m_renderThread.post([this] { renderSurface(); });
+}
+
+void Renderer::uploadSurface(
+    uint32_t width, uint32_t height, const std::vector<uint8_t>& data)
 {
     m_surfaceTexture.bind();
 
     // update buffer if the size is unchanged, otherwise create a new one
-    if (desc.dwWidth != m_width || desc.dwHeight != m_height) {
-        m_width = desc.dwWidth;
-        m_height = desc.dwHeight;
+    if (width != m_width || height != m_height) {
+        m_width = width;
+        m_height = height;
         glTexImage2D(GL_TEXTURE_2D, 0, TEX_INTERNAL_FORMAT, m_width, m_height,
             0, TEX_FORMAT, TEX_TYPE, &data[0]);
     } else {
@@ -51,33 +77,21 @@ void Renderer::upload(DDSURFACEDESC& desc, std::vector<uint8_t>& data)
     }
 }
 
-void Renderer::render()
+void Renderer::renderSurface()
 {
     m_program.bind();
     m_surfaceFormat.bind();
-    m_surfaceTexture.bind();
+    m_glState.bindTexture(0, GL_TEXTURE_2D, m_surfaceTexture.id());
     m_sampler.bind(0);
 
-    GLboolean blend = glIsEnabled(GL_BLEND);
-    if (blend) {
-        glDisable(GL_BLEND);
-    }
-
-    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
-    if (depthTest) {
-        glDisable(GL_DEPTH_TEST);
-    }
+    // other renderers set up their own state through the cache as well, so
+    // there's no need to restore the previous one
+    m_glState.enable(GL_BLEND, false);
+    m_glState.enable(GL_DEPTH_TEST, false);
+    m_glState.polygonMode(GL_FILL);
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
-    if (blend) {
-        glEnable(GL_BLEND);
-    }
-
-    if (depthTest) {
-        glEnable(GL_DEPTH_TEST);
-    }
-
     gl::Utils::checkError(__FUNCTION__);
 }
 
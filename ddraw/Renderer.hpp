@@ -24,12 +24,18 @@ public:
     void render();
 
 private:
+    void uploadSurface(
+        uint32_t width, uint32_t height, const std::vector<uint8_t>& data);
+    void renderSurface();
+
     static const GLenum TEX_INTERNAL_FORMAT = GL_RGBA;
     static const GLenum TEX_FORMAT = GL_BGRA;
     static const GLenum TEX_TYPE = GL_UNSIGNED_SHORT_1_5_5_5_REV;
 
     Context& m_context{GLRage::getContext()};
     Config& m_config{GLRage::getConfig()};
+    RenderThread& m_renderThread{GLRage::getRenderThread()};
+    gl::StateCache& m_glState{GLRage::getGLState()};
     uint32_t m_width = 0;
     uint32_t m_height = 0;
     gl::VertexArray m_surfaceFormat;
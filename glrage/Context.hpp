@@ -16,6 +16,8 @@ public:
     virtual void attach(HWND hwnd) = 0;
     virtual void attach() = 0;
     virtual void detach() = 0;
+    virtual void startRenderThread() = 0;
+    virtual void stopRenderThread() = 0;
     virtual LRESULT windowProc(
         HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) = 0;
     virtual BOOL enumWindowsProc(HWND hwnd) = 0;
@@ -32,6 +34,8 @@ public:
     virtual int32_t getScreenHeight() = 0;
     virtual void setupViewport() = 0;
     virtual void swapBuffers() = 0;
+    virtual float getFrameTime() = 0;
+    virtual float getFrameWaitTime() = 0;
     virtual void setRendered() = 0;
     virtual bool isRendered() = 0;
     virtual HWND getHWnd() = 0;
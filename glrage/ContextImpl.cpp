@@ -4,6 +4,7 @@
 #include <glrage_util/Logger.hpp>
 #include <glrage_util/StringUtils.hpp>
 
+#include <glrage_gl/StateCache.hpp>
 #include <glrage_gl/gl_core_3_3.h>
 #include <glrage_gl/wgl_ext.h>
 
@@ -108,12 +109,28 @@ void ContextImpl::init()
             ErrorUtils::getWindowsErrorString());
     }
 
-    glClearColor(0, 0, 0, 0);
-    glClearDepth(1);
-
-    if (m_config.getBool("context.vsync", true)) {
-        wglSwapIntervalEXT(1);
+    // number of frames the CPU may get ahead of the GPU
+    int32_t framesInFlight = m_config.getInt("context.frames_in_flight", 1);
+    if (framesInFlight < 1) {
+        framesInFlight = 1;
+    } else if (framesInFlight > 3) {
+        framesInFlight = 3;
     }
+    m_framesInFlight = framesInFlight;
+    m_frameStart = std::chrono::steady_clock::now();
+
+    bool vsync = m_config.getBool("context.vsync", true);
+    m_renderThread.call([vsync] {
+        // nothing is known about the state of the new context
+        gl::StateCache::current().invalidate();
+
+        glClearColor(0, 0, 0, 0);
+        glClearDepth(1);
+
+        if (vsync) {
+            wglSwapIntervalEXT(1);
+        }
+    });
 }
 
 void ContextImpl::attach(HWND hwnd)
@@ -135,7 +152,7 @@ void ContextImpl::attach(HWND hwnd)
     SetWindowLongPtr(m_hwnd, GWLP_WNDPROC, windowProc);
 
     // detach from current window
-    wglMakeCurrent(NULL, NULL);
+    m_renderThread.call([] { wglMakeCurrent(NULL, NULL); });
 
     // destroy temporary window
     if (m_hwndTmp) {
@@ -152,10 +169,12 @@ void ContextImpl::attach(HWND hwnd)
     }
 
     // set context on new window
-    if (!m_hglrc_core || !wglMakeCurrent(m_hdc, m_hglrc_core)) {
-        ErrorUtils::error("Can't attach window to OpenGL context",
-            ErrorUtils::getWindowsErrorString());
-    }
+    m_renderThread.call([this] {
+        if (!m_hglrc_core || !wglMakeCurrent(m_hdc, m_hglrc_core)) {
+            ErrorUtils::error("Can't attach window to OpenGL context",
+                ErrorUtils::getWindowsErrorString());
+        }
+    });
 
     // apply previously applied window size
     if (m_width > 0 && m_height > 0) {
@@ -182,10 +201,21 @@ void ContextImpl::detach()
         return;
     }
 
-    wglDeleteContext(m_hglrc);
-    m_hglrc = nullptr;
+    // the context can only be deleted by the thread it's current to
+    m_renderThread.call([this] {
+        for (auto fence : m_frameFences) {
+            glDeleteSync(fence);
+        }
+        m_frameFences.clear();
 
-    wglDeleteContext(m_hglrc_core);
+        wglMakeCurrent(NULL, NULL);
+        wglDeleteContext(m_hglrc);
+        wglDeleteContext(m_hglrc_core);
+    });
+    m_renderThread.stop();
+    m_renderThreadUsers = 0;
+
+    m_hglrc = nullptr;
     m_hglrc_core = nullptr;
 
     auto windowProc = reinterpret_cast<LONG_PTR>(m_windowProc);
@@ -195,6 +225,45 @@ void ContextImpl::detach()
     m_hwnd = nullptr;
 }
 
+void ContextImpl::startRenderThread()
+{
+    if (m_renderThreadUsers++ > 0 || !m_hglrc_core) {
+        return;
+    }
+
+    // optionally hand the context over to a dedicated render thread, which
+    // executes all following GL commands
+    if (m_config.getBool("context.render_thread", false)) {
+        wglMakeCurrent(NULL, NULL);
+        m_renderThread.start(
+            m_config.getInt("context.render_queue_depth", 1024));
+        m_renderThread.call([this] {
+            if (!wglMakeCurrent(m_hdc, m_hglrc_core)) {
+                ErrorUtils::error("Can't move OpenGL context to render thread",
+                    ErrorUtils::getWindowsErrorString());
+            }
+        });
+    }
+}
+
+void ContextImpl::stopRenderThread()
+{
+    if (m_renderThreadUsers == 0 || --m_renderThreadUsers > 0 ||
+        !m_renderThread.active()) {
+        return;
+    }
+
+    // finish all pending commands and hand the context back to the
+    // application thread
+    m_renderThread.call([] { wglMakeCurrent(NULL, NULL); });
+    m_renderThread.stop();
+
+    if (!wglMakeCurrent(m_hdc, m_hglrc_core)) {
+        ErrorUtils::error("Can't move OpenGL context to application thread",
+            ErrorUtils::getWindowsErrorString());
+    }
+}
+
 LRESULT
 ContextImpl::windowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
@@ -424,25 +493,68 @@ void ContextImpl::setupViewport()
         vpHeight = hMax;
     }
 
-    glViewport(vpX, vpY, vpWidth, vpHeight);
+    m_renderThread.post([vpX, vpY, vpWidth, vpHeight] {
+        glViewport(vpX, vpY, vpWidth, vpHeight);
+    });
 }
 
 void ContextImpl::swapBuffers()
 {
-    glFinish();
+    m_renderThread.post([this] {
+        try {
+            m_screenshot.captureScheduled();
+        } catch (const std::exception& ex) {
+            ErrorUtils::warning("Can't capture screenshot", ex);
+            m_screenshot.schedule(false);
+        }
+
+        SwapBuffers(m_hdc);
+        waitForFrames();
+        glDrawBuffer(GL_BACK);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    });
+
+    // only used by the application thread, so it's reset right away
+    m_render = false;
+}
 
-    try {
-        m_screenshot.captureScheduled();
-    } catch (const std::exception& ex) {
-        ErrorUtils::warning("Can't capture screenshot", ex);
-        m_screenshot.schedule(false);
-    }
+float ContextImpl::getFrameTime()
+{
+    return m_frameTime;
+}
 
-    SwapBuffers(m_hdc);
-    glDrawBuffer(GL_BACK);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+float ContextImpl::getFrameWaitTime()
+{
+    return m_frameWaitTime;
+}
 
-    m_render = false;
+void ContextImpl::waitForFrames()
+{
+    // Instead of draining the GPU every frame, only wait for the frame that
+    // has fallen more than the configured number of frames behind, so CPU
+    // and GPU work can overlap.
+    m_frameFences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    auto waitStart = std::chrono::steady_clock::now();
+    while (m_frameFences.size() > m_framesInFlight) {
+        GLsync fence = m_frameFences.front();
+        m_frameFences.pop_front();
+
+        GLenum result;
+        do {
+            result = glClientWaitSync(
+                fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        glDeleteSync(fence);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<float, std::milli> waitTime = now - waitStart;
+    std::chrono::duration<float, std::milli> frameTime = now - m_frameStart;
+    m_frameWaitTime = waitTime.count();
+    m_frameTime = frameTime.count();
+    m_frameStart = now;
 }
 
 void ContextImpl::setRendered()
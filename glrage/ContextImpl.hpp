@@ -4,6 +4,13 @@
 #include "Screenshot.hpp"
 
 #include <glrage_util/Config.hpp>
+#include <glrage_util/RenderThread.hpp>
+
+#include <glrage_gl/gl_core_3_3.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
 
 namespace glrage {
 
@@ -19,6 +26,8 @@ public:
     void attach(HWND hwnd);
     void attach();
     void detach();
+    void startRenderThread();
+    void stopRenderThread();
     LRESULT windowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
     BOOL enumWindowsProc(HWND hwnd);
     bool isFullscreen();
@@ -34,6 +43,8 @@ public:
     int32_t getScreenHeight();
     void setupViewport();
     void swapBuffers();
+    float getFrameTime();
+    float getFrameWaitTime();
     void setRendered();
     bool isRendered();
     HWND getHWnd();
@@ -51,10 +62,20 @@ private:
         WS_CAPTION | WS_THICKFRAME | WS_OVERLAPPED | WS_SYSMENU;
     static const LONG STYLE_WINDOW_EX = WS_EX_DLGMODALFRAME | WS_EX_WINDOWEDGE |
                                         WS_EX_CLIENTEDGE | WS_EX_STATICEDGE;
+    static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+    void waitForFrames();
 
     // config object
     Config& m_config{Config::instance()};
 
+    // optional thread that owns the OpenGL context
+    RenderThread& m_renderThread{RenderThread::instance()};
+
+    // number of CIF and DirectDraw instances that use the render thread, it's
+    // stopped when the last one is released
+    uint32_t m_renderThreadUsers = 0;
+
     // window handle
     HWND m_hwnd = nullptr;
     HWND m_hwndTmp = nullptr;
@@ -84,6 +105,16 @@ private:
     // rendering flag
     bool m_render = false;
 
+    // fences of the frames the GPU may still be working on
+    std::deque<GLsync> m_frameFences;
+    uint32_t m_framesInFlight = 1;
+
+    // duration of the last frame and the part of it that was spent waiting
+    // for the GPU, in milliseconds
+    std::chrono::steady_clock::time_point m_frameStart;
+    std::atomic<float> m_frameTime{0};
+    std::atomic<float> m_frameWaitTime{0};
+
     // screenshot object
     Screenshot m_screenshot;
 
@@ -2,8 +2,10 @@
 
 #include "ContextImpl.hpp"
 
+#include <glrage_gl/StateCache.hpp>
 #include <glrage_patch/RuntimePatcher.hpp>
 #include <glrage_util/Config.hpp>
+#include <glrage_util/RenderThread.hpp>
 
 namespace glrage {
 
@@ -20,6 +22,8 @@ public:
     static GLRAPI Context& getContext();
     static GLRAPI RuntimePatcher& getPatcher();
     static GLRAPI Config& getConfig();
+    static GLRAPI gl::StateCache& getGLState();
+    static GLRAPI RenderThread& getRenderThread();
 
 private:
     static ContextImpl m_context;
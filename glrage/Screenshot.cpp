@@ -1,18 +1,29 @@
 #include "Screenshot.hpp"
 #include "ContextImpl.hpp"
 
+#include <glrage_util/ErrorUtils.hpp>
 #include <glrage_util/StringUtils.hpp>
 #include <glrage_gl/Screenshot.hpp>
+#include <glrage_gl/StateCache.hpp>
 
 #include <cstdint>
+#include <cstring>
 #include <exception>
-#include <fstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 namespace glrage {
 
+static const GLint DEPTH = 3;
+
+Screenshot::~Screenshot()
+{
+    if (m_encoder.valid()) {
+        m_encoder.wait();
+    }
+}
+
 void Screenshot::schedule(bool schedule)
 {
     m_schedule = schedule;
@@ -20,32 +31,104 @@ void Screenshot::schedule(bool schedule)
 
 void Screenshot::captureScheduled()
 {
-    if (m_schedule) {
+    if (m_fence) {
+        finishReadback(++m_fenceFrames >= READBACK_FRAMES);
+    }
+
+    // only one read back is pending at a time, further requests wait
+    if (!m_fence && m_schedule.exchange(false)) {
         capture();
-        m_schedule = false;
     }
 }
 
 void Screenshot::capture()
 {
-    // find unused screenshot file name
+    if (!m_buffer) {
+        m_buffer = std::make_unique<gl::Buffer>(GL_PIXEL_PACK_BUFFER);
+    }
+
+    m_path = nextPath();
+    gl::Screenshot::captureAsync(
+        *m_buffer, m_width, m_height, DEPTH, GL_BGR, GL_UNSIGNED_BYTE);
+    m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_fenceFrames = 0;
+}
+
+void Screenshot::finishReadback(bool wait)
+{
+    GLuint64 timeout = wait ? FENCE_TIMEOUT : 0;
+    GLenum result =
+        glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (result == GL_TIMEOUT_EXPIRED && !wait) {
+        return;
+    }
+
+    glDeleteSync(m_fence);
+    m_fence = nullptr;
+
+    // copy the pixels out of the buffer, so it can be unmapped right away
+    auto pixels = std::make_shared<std::vector<uint8_t>>(
+        static_cast<size_t>(m_width * m_height * DEPTH));
+    m_buffer->bind();
+    void* data = m_buffer->map(GL_READ_ONLY);
+    if (data) {
+        memcpy(&(*pixels)[0], data, pixels->size());
+    }
+    m_buffer->unmap();
+    gl::StateCache::current().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (!data) {
+        throw std::runtime_error("Can't map screenshot buffer");
+    }
+
+    // write the file in the background, one screenshot at a time
+    if (m_encoder.valid()) {
+        m_encoder.wait();
+    }
+
+    std::wstring path = m_path;
+    GLint width = m_width;
+    GLint height = m_height;
+    m_encoder = std::async(std::launch::async, [path, pixels, width, height] {
+        try {
+            gl::Screenshot::save(path, *pixels, width, height, DEPTH);
+        } catch (const std::exception& ex) {
+            ErrorUtils::warning("Can't save screenshot", ex);
+        }
+    });
+}
+
+std::wstring Screenshot::nextPath()
+{
     std::wstring basePath = ContextImpl::instance().getBasePath();
-    std::wstring path;
-    DWORD dwAttrib;
-    do {
-        std::string fileName =
-            StringUtils::format("screenshot%04d.tga", m_index++);
-        path = basePath + L"\\" + StringUtils::utf8ToWide(fileName);
-        dwAttrib = GetFileAttributes(path.c_str());
-    } while (dwAttrib != INVALID_FILE_ATTRIBUTES && m_index < 9999);
+
+    // look for the highest index in use once, later screenshots just count up
+    if (m_index < 0) {
+        m_index = 0;
+
+        WIN32_FIND_DATA findData;
+        std::wstring pattern = basePath + L"\\screenshot*.tga";
+        HANDLE find = FindFirstFile(pattern.c_str(), &findData);
+        if (find != INVALID_HANDLE_VALUE) {
+            do {
+                int32_t index = 0;
+                if (swscanf_s(findData.cFileName, L"screenshot%d.tga",
+                        &index) == 1 &&
+                    index >= m_index) {
+                    m_index = index + 1;
+                }
+            } while (FindNextFile(find, &findData));
+            FindClose(find);
+        }
+    }
 
     // rather unlikely, but better safe than sorry
-    if (dwAttrib != INVALID_FILE_ATTRIBUTES) {
+    if (m_index > 9999) {
         throw std::runtime_error("All available screenshot slots are used up!");
     }
 
-    // actual capture
-    gl::Screenshot::capture(path);
+    std::string fileName = StringUtils::format("screenshot%04d.tga", m_index++);
+    return basePath + L"\\" + StringUtils::utf8ToWide(fileName);
 }
 
 } // namespace glrage
\ No newline at end of file
@@ -1,19 +1,50 @@
 #pragma once
 
+#include <glrage_gl/Buffer.hpp>
+
+#include <atomic>
 #include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
 
 namespace glrage {
 
+// Captures the front buffer into a pixel buffer, which is read back a few
+// frames later, when the GPU is done with it. The file is written by a worker
+// thread, so neither step stalls rendering.
 class Screenshot
 {
 public:
+    ~Screenshot();
     void schedule(bool schedule);
     void captureScheduled();
-    void capture();
 
 private:
-    uint32_t m_index = 0;
-    bool m_schedule = false;
+    // frames after which a pending read back is forced to finish
+    static const uint32_t READBACK_FRAMES = 2;
+    static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+    void capture();
+    void finishReadback(bool wait);
+    std::wstring nextPath();
+
+    std::atomic<bool> m_schedule{false};
+
+    // next unused file index, -1 until the directory has been scanned
+    int32_t m_index = -1;
+
+    // pending read back, the buffer is created on first use, since there's no
+    // GL context yet when the object is constructed
+    std::unique_ptr<gl::Buffer> m_buffer;
+    GLsync m_fence = nullptr;
+    uint32_t m_fenceFrames = 0;
+    GLint m_width = 0;
+    GLint m_height = 0;
+    std::wstring m_path;
+
+    // encoding of the previous screenshot
+    std::future<void> m_encoder;
 };
 
 } // namespace glrage
\ No newline at end of file
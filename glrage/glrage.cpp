@@ -17,4 +17,14 @@ GLRAPI Config& GLRage::getConfig()
     return Config::instance();
 }
 
+GLRAPI gl::StateCache& GLRage::getGLState()
+{
+    return gl::StateCache::current();
+}
+
+GLRAPI RenderThread& GLRage::getRenderThread()
+{
+    return RenderThread::instance();
+}
+
 } // namespace glrage
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Buffer.hpp"
+#include "StateCache.hpp"
 
 namespace glrage {
 namespace gl {
@@ -12,11 +13,17 @@ Buffer::Buffer(GLenum target)
 Buffer::~Buffer()
 {
     glDeleteBuffers(1, &m_id);
+    StateCache::current().bufferDeleted(m_id);
 }
 
 void Buffer::bind()
 {
-    glBindBuffer(m_target, m_id);
+    StateCache::current().bindBuffer(m_target, m_id);
+}
+
+void Buffer::bindBase(GLuint index)
+{
+    StateCache::current().bindBufferBase(m_target, index, m_id);
 }
 
 void Buffer::data(GLsizei size, const void* data, GLenum usage)
@@ -12,6 +12,7 @@ public:
     Buffer(GLenum target);
     ~Buffer();
     void bind();
+    void bindBase(GLuint index);
     void data(GLsizei size, const void* data, GLenum usage);
     void subData(GLsizei offset, GLsizei size, const void* data);
     void* map(GLenum access);
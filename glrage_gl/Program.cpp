@@ -1,5 +1,6 @@
 #include "Program.hpp"
 #include "ProgramException.hpp"
+#include "StateCache.hpp"
 
 #include <glrage_util/Logger.hpp>
 
@@ -18,12 +19,13 @@ Program::~Program()
 {
     if (m_id) {
         glDeleteProgram(m_id);
+        StateCache::current().programDeleted(m_id);
     }
 }
 
 void Program::bind()
 {
-    glUseProgram(m_id);
+    StateCache::current().useProgram(m_id);
 }
 
 void Program::attach(Shader& shader)
@@ -92,12 +94,24 @@ GLint Program::uniformLocation(const std::string& name)
     return location;
 }
 
+void Program::uniformBlockBinding(const std::string& name, GLuint binding)
+{
+    GLuint index = glGetUniformBlockIndex(m_id, name.c_str());
+    if (index == GL_INVALID_INDEX) {
+        LOG_INFO("Shader uniform block not found: " + name);
+        return;
+    }
+
+    glUniformBlockBinding(m_id, index, binding);
+}
+
 void Program::uniform3f(
     const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2)
 {
     GLint loc = uniformLocation(name);
     if (loc != -1) {
         glUniform3f(loc, v0, v1, v2);
+        m_uniformStats.issued++;
     }
 }
 
@@ -107,6 +121,7 @@ void Program::uniform4f(
     GLint loc = uniformLocation(name);
     if (loc != -1) {
         glUniform4f(loc, v0, v1, v2, v3);
+        m_uniformStats.issued++;
     }
 }
 
@@ -115,6 +130,7 @@ void Program::uniform1i(const std::string& name, GLint v0)
     GLint loc = uniformLocation(name);
     if (loc != -1) {
         glUniform1i(loc, v0);
+        m_uniformStats.issued++;
     }
 }
 
@@ -124,9 +140,15 @@ void Program::uniformMatrix4fv(const std::string& name, GLsizei count,
     GLint loc = uniformLocation(name);
     if (loc != -1) {
         glUniformMatrix4fv(loc, count, transpose, value);
+        m_uniformStats.issued++;
     }
 }
 
+const UniformStats& Program::uniformStats()
+{
+    return m_uniformStats;
+}
+
 std::string Program::infoLog()
 {
     GLint infoLogLength;
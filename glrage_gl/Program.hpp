@@ -2,6 +2,7 @@
 
 #include "Object.hpp"
 #include "Shader.hpp"
+#include "Uniform.hpp"
 #include "gl_core_3_3.h"
 
 #include <map>
@@ -21,6 +22,14 @@ public:
     void fragmentData(const std::string& name);
     GLint attributeLocation(const std::string& name);
     GLint uniformLocation(const std::string& name);
+    void uniformBlockBinding(const std::string& name, GLuint binding);
+
+    template <typename T> Uniform<T> uniform(const std::string& name)
+    {
+        return Uniform<T>(uniformLocation(name), &m_uniformStats);
+    }
+
+    const UniformStats& uniformStats();
 
     void uniform3f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2);
     void uniform4f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2,
@@ -34,6 +43,7 @@ public:
 private:
     std::map<std::string, GLint> m_attributeLocations;
     std::map<std::string, GLint> m_uniformLocations;
+    UniformStats m_uniformStats{};
 };
 
 } // namespace gl
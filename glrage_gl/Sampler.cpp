@@ -1,4 +1,5 @@
 #include "Sampler.hpp"
+#include "StateCache.hpp"
 
 namespace glrage {
 namespace gl {
@@ -11,6 +12,7 @@ Sampler::Sampler()
 Sampler::~Sampler()
 {
     glDeleteSamplers(1, &m_id);
+    StateCache::current().samplerDeleted(m_id);
 }
 
 void Sampler::bind()
@@ -19,7 +21,7 @@ void Sampler::bind()
 
 void Sampler::bind(GLuint unit)
 {
-    glBindSampler(unit, m_id);
+    StateCache::current().bindSampler(unit, m_id);
 }
 
 void Sampler::parameteri(GLenum pname, GLint param)
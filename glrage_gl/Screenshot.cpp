@@ -1,4 +1,5 @@
 #include "Screenshot.hpp"
+#include "StateCache.hpp"
 
 #include <glrage_util/ErrorUtils.hpp>
 #include <glrage_util/StringUtils.hpp>
@@ -26,7 +27,52 @@ struct TGAHeader
     uint8_t blank3;
 };
 
-void Screenshot::capture(const std::wstring& path)
+void Screenshot::capture(std::vector<uint8_t>& buffer, GLint& width,
+    GLint& height, GLint depth, GLenum format, GLenum type, bool vflip)
+{
+    GLint x;
+    GLint y;
+    readViewport(x, y, width, height);
+
+    GLint pitch = width * depth;
+    buffer.resize(pitch * height);
+
+    glReadPixels(x, y, width, height, format, type, &buffer[0]);
+
+    if (vflip) {
+        flip(buffer, pitch, height);
+    }
+}
+
+void Screenshot::captureAsync(Buffer& buffer, GLint& width, GLint& height,
+    GLint depth, GLenum format, GLenum type)
+{
+    GLint x;
+    GLint y;
+    readViewport(x, y, width, height);
+
+    // with a pack buffer bound, the pixels are written to the buffer at the
+    // given offset and the call returns without waiting for the GPU
+    buffer.bind();
+    buffer.data(width * height * depth, nullptr, GL_STREAM_READ);
+    glReadPixels(x, y, width, height, format, type, nullptr);
+
+    // unbind it again, so other read backs still go to client memory
+    StateCache::current().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void Screenshot::flip(std::vector<uint8_t>& buffer, GLint pitch, GLint height)
+{
+    for (GLint i = 0, middle = height / 2; i < middle; i++) {
+        auto first1 = std::next(buffer.begin(), i * pitch);
+        auto last1 = std::next(buffer.begin(), (i + 1) * pitch);
+        auto first2 = std::prev(buffer.end(), (i + 1) * pitch);
+        std::swap_ranges(first1, last1, first2);
+    }
+}
+
+void Screenshot::save(const std::wstring& path, std::vector<uint8_t>& buffer,
+    GLint width, GLint height, GLint depth)
 {
     // open screenshot file
     std::ofstream file(path, std::ofstream::binary);
@@ -36,15 +82,7 @@ void Screenshot::capture(const std::wstring& path)
                                  ErrorUtils::getSystemErrorString());
     }
 
-    // copy framebuffer to local buffer
-    GLint width;
-    GLint height;
-    GLint depth = 3;
-
-    std::vector<uint8_t> buffer;
-    capture(buffer, width, height, depth, GL_BGR, GL_UNSIGNED_BYTE, false);
-
-    // create Targa header
+    // create Targa header, rows are stored bottom to top like in OpenGL
     TGAHeader tgaHeader = {0};
     tgaHeader.format = 2;
     tgaHeader.width = width;
@@ -56,33 +94,19 @@ void Screenshot::capture(const std::wstring& path)
     file.close();
 }
 
-void Screenshot::capture(std::vector<uint8_t>& buffer, GLint& width,
-    GLint& height, GLint depth, GLenum format, GLenum type, bool vflip)
+void Screenshot::readViewport(GLint& x, GLint& y, GLint& width, GLint& height)
 {
     GLint viewport[4];
     glGetIntegerv(GL_VIEWPORT, viewport);
 
-    GLint x = viewport[0];
-    GLint y = viewport[1];
+    x = viewport[0];
+    y = viewport[1];
     width = viewport[2];
     height = viewport[3];
 
-    GLint pitch = width * depth;
-    buffer.resize(pitch * height);
-
     glPixelStorei(GL_PACK_ALIGNMENT, 1);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glReadBuffer(GL_FRONT);
-    glReadPixels(x, y, width, height, format, type, &buffer[0]);
-
-    if (vflip) {
-        for (GLint i = 0, middle = height / 2; i < middle; i++) {
-            auto first1 = std::next(buffer.begin(), i * pitch);
-            auto last1 = std::next(buffer.begin(), (i + 1) * pitch);
-            auto first2 = std::prev(buffer.end(), (i + 1) * pitch);
-            std::swap_ranges(first1, last1, first2);
-        }
-    }
 }
 
 } // namespace gl
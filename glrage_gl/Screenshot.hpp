@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Buffer.hpp"
+
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -12,10 +14,17 @@ namespace gl {
 class Screenshot
 {
 public:
-    static void capture(const std::wstring& path);
     static void capture(std::vector<uint8_t>& buffer, GLint& width,
         GLint& height, GLint depth, GLenum format, GLenum type,
         bool vflip = false);
+    static void captureAsync(Buffer& buffer, GLint& width, GLint& height,
+        GLint depth, GLenum format, GLenum type);
+    static void flip(std::vector<uint8_t>& buffer, GLint pitch, GLint height);
+    static void save(const std::wstring& path, std::vector<uint8_t>& buffer,
+        GLint width, GLint height, GLint depth);
+
+private:
+    static void readViewport(GLint& x, GLint& y, GLint& width, GLint& height);
 };
 
 } // namespace gl
@@ -0,0 +1,313 @@
+#include "StateCache.hpp"
+
+namespace glrage {
+namespace gl {
+
+namespace {
+
+StateCache* currentCache = nullptr;
+
+} // namespace
+
+StateCache& StateCache::current()
+{
+    // modules that don't share a cache fall back to their own instance
+    if (!currentCache) {
+        static StateCache instance;
+        currentCache = &instance;
+    }
+
+    return *currentCache;
+}
+
+void StateCache::setCurrent(StateCache& cache)
+{
+    currentCache = &cache;
+}
+
+StateCache::StateCache()
+{
+    invalidate();
+}
+
+void StateCache::invalidate()
+{
+    m_program = UNKNOWN;
+    m_vertexArray = UNKNOWN;
+    m_buffers.fill(UNKNOWN);
+    m_uniformBases.fill(UNKNOWN);
+    m_activeTexture = UNKNOWN;
+    for (auto& unit : m_textures) {
+        unit.fill(UNKNOWN);
+    }
+    m_samplers.fill(UNKNOWN);
+    m_caps.fill(UNKNOWN);
+    m_blendSrc = UNKNOWN;
+    m_blendDst = UNKNOWN;
+    m_depthFunc = UNKNOWN;
+    m_depthMask = UNKNOWN;
+    m_polygonMode = UNKNOWN;
+}
+
+const StateCacheStats& StateCache::stats()
+{
+    return m_stats;
+}
+
+bool StateCache::useProgram(GLuint program)
+{
+    if (!update(m_program, program)) {
+        return false;
+    }
+
+    glUseProgram(program);
+    return true;
+}
+
+bool StateCache::bindVertexArray(GLuint vertexArray)
+{
+    if (!update(m_vertexArray, vertexArray)) {
+        return false;
+    }
+
+    glBindVertexArray(vertexArray);
+
+    // the element array binding is part of the vertex array state
+    m_buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+    return true;
+}
+
+bool StateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    int index = bufferTarget(target);
+    if (index >= 0 && !update(m_buffers[index], buffer)) {
+        return false;
+    }
+
+    glBindBuffer(target, buffer);
+    return true;
+}
+
+bool StateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    // binding an indexed target also binds the generic one
+    int generic = bufferTarget(target);
+    if (generic >= 0) {
+        m_buffers[generic] = buffer;
+    }
+
+    if (target == GL_UNIFORM_BUFFER && index < MAX_BUFFER_BASES &&
+        !update(m_uniformBases[index], buffer)) {
+        return false;
+    }
+
+    glBindBufferBase(target, index, buffer);
+    return true;
+}
+
+bool StateCache::activeTexture(GLuint unit)
+{
+    if (!update(m_activeTexture, unit)) {
+        return false;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    return true;
+}
+
+bool StateCache::bindTexture(GLenum target, GLuint texture)
+{
+    int index = textureTarget(target);
+    if (index >= 0 && m_activeTexture < MAX_TEXTURE_UNITS &&
+        !update(m_textures[m_activeTexture][index], texture)) {
+        return false;
+    }
+
+    glBindTexture(target, texture);
+    return true;
+}
+
+bool StateCache::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    activeTexture(unit);
+    return bindTexture(target, texture);
+}
+
+bool StateCache::bindSampler(GLuint unit, GLuint sampler)
+{
+    if (unit < MAX_TEXTURE_UNITS && !update(m_samplers[unit], sampler)) {
+        return false;
+    }
+
+    glBindSampler(unit, sampler);
+    return true;
+}
+
+bool StateCache::enable(GLenum cap, bool enabled)
+{
+    int index = capability(cap);
+    if (index >= 0 && !update(m_caps[index], enabled)) {
+        return false;
+    }
+
+    if (enabled) {
+        glEnable(cap);
+    } else {
+        glDisable(cap);
+    }
+    return true;
+}
+
+bool StateCache::blendFunc(GLenum src, GLenum dst)
+{
+    if (src == m_blendSrc && dst == m_blendDst) {
+        m_stats.skipped++;
+        return false;
+    }
+
+    m_blendSrc = src;
+    m_blendDst = dst;
+    m_stats.issued++;
+    glBlendFunc(src, dst);
+    return true;
+}
+
+bool StateCache::depthFunc(GLenum func)
+{
+    if (!update(m_depthFunc, func)) {
+        return false;
+    }
+
+    glDepthFunc(func);
+    return true;
+}
+
+bool StateCache::depthMask(GLboolean flag)
+{
+    if (!update(m_depthMask, flag)) {
+        return false;
+    }
+
+    glDepthMask(flag);
+    return true;
+}
+
+bool StateCache::polygonMode(GLenum mode)
+{
+    if (!update(m_polygonMode, mode)) {
+        return false;
+    }
+
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+    return true;
+}
+
+void StateCache::programDeleted(GLuint program)
+{
+    // deleting the current program is deferred until it's no longer in use,
+    // so its name can't be trusted anymore
+    if (m_program == program) {
+        m_program = UNKNOWN;
+    }
+}
+
+void StateCache::vertexArrayDeleted(GLuint vertexArray)
+{
+    if (m_vertexArray == vertexArray) {
+        m_vertexArray = 0;
+        m_buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+    }
+}
+
+void StateCache::bufferDeleted(GLuint buffer)
+{
+    for (auto& binding : m_buffers) {
+        if (binding == buffer) {
+            binding = 0;
+        }
+    }
+
+    // indexed bindings aren't reset by all drivers
+    for (auto& binding : m_uniformBases) {
+        if (binding == buffer) {
+            binding = UNKNOWN;
+        }
+    }
+}
+
+void StateCache::textureDeleted(GLuint texture)
+{
+    for (auto& unit : m_textures) {
+        for (auto& binding : unit) {
+            if (binding == texture) {
+                binding = 0;
+            }
+        }
+    }
+}
+
+void StateCache::samplerDeleted(GLuint sampler)
+{
+    for (auto& binding : m_samplers) {
+        if (binding == sampler) {
+            binding = 0;
+        }
+    }
+}
+
+int StateCache::bufferTarget(GLenum target)
+{
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            return BUFFER_ARRAY;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return BUFFER_ELEMENT_ARRAY;
+        case GL_UNIFORM_BUFFER:
+            return BUFFER_UNIFORM;
+        case GL_PIXEL_PACK_BUFFER:
+            return BUFFER_PIXEL_PACK;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return BUFFER_PIXEL_UNPACK;
+        default:
+            return -1;
+    }
+}
+
+int StateCache::textureTarget(GLenum target)
+{
+    switch (target) {
+        case GL_TEXTURE_2D:
+            return TEXTURE_2D;
+        case GL_TEXTURE_2D_ARRAY:
+            return TEXTURE_2D_ARRAY;
+        default:
+            return -1;
+    }
+}
+
+int StateCache::capability(GLenum cap)
+{
+    switch (cap) {
+        case GL_BLEND:
+            return CAP_BLEND;
+        case GL_DEPTH_TEST:
+            return CAP_DEPTH_TEST;
+        default:
+            return -1;
+    }
+}
+
+bool StateCache::update(GLuint& shadow, GLuint value)
+{
+    if (shadow == value) {
+        m_stats.skipped++;
+        return false;
+    }
+
+    shadow = value;
+    m_stats.issued++;
+    return true;
+}
+
+} // namespace gl
+} // namespace glrage
\ No newline at end of file
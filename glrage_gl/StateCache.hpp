@@ -0,0 +1,110 @@
+#pragma once
+
+#include "gl_core_3_3.h"
+
+#include <array>
+#include <cstdint>
+
+namespace glrage {
+namespace gl {
+
+// counters of state changes that went through the cache
+struct StateCacheStats
+{
+    uint32_t issued;
+    uint32_t skipped;
+};
+
+// Shadow copy of the GL bindings and fixed function state. Redundant changes
+// are filtered without ever querying the driver, so all code sharing the
+// context must change the covered state through the cache. Everything starts
+// out as unknown, so the first change of each value is always issued.
+//
+// The instance of each module must point to the one of glrage.dll, see
+// setCurrent().
+class StateCache
+{
+public:
+    static const GLuint MAX_TEXTURE_UNITS = 16;
+    static const GLuint MAX_BUFFER_BASES = 16;
+
+    static StateCache& current();
+    static void setCurrent(StateCache& cache);
+
+    StateCache();
+    void invalidate();
+    const StateCacheStats& stats();
+
+    bool useProgram(GLuint program);
+    bool bindVertexArray(GLuint vertexArray);
+    bool bindBuffer(GLenum target, GLuint buffer);
+    bool bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    bool activeTexture(GLuint unit);
+    bool bindTexture(GLenum target, GLuint texture);
+    bool bindTexture(GLuint unit, GLenum target, GLuint texture);
+    bool bindSampler(GLuint unit, GLuint sampler);
+    bool enable(GLenum cap, bool enabled);
+    bool blendFunc(GLenum src, GLenum dst);
+    bool depthFunc(GLenum func);
+    bool depthMask(GLboolean flag);
+    bool polygonMode(GLenum mode);
+
+    // deleted objects are unbound by GL and their names may be reused
+    void programDeleted(GLuint program);
+    void vertexArrayDeleted(GLuint vertexArray);
+    void bufferDeleted(GLuint buffer);
+    void textureDeleted(GLuint texture);
+    void samplerDeleted(GLuint sampler);
+
+private:
+    static const GLuint UNKNOWN = 0xffffffff;
+
+    enum BufferTarget
+    {
+        BUFFER_ARRAY,
+        BUFFER_ELEMENT_ARRAY,
+        BUFFER_UNIFORM,
+        BUFFER_PIXEL_PACK,
+        BUFFER_PIXEL_UNPACK,
+        BUFFER_TARGET_NUM
+    };
+
+    enum TextureTarget
+    {
+        TEXTURE_2D,
+        TEXTURE_2D_ARRAY,
+        TEXTURE_TARGET_NUM
+    };
+
+    enum Capability
+    {
+        CAP_BLEND,
+        CAP_DEPTH_TEST,
+        CAP_NUM
+    };
+
+    static int bufferTarget(GLenum target);
+    static int textureTarget(GLenum target);
+    static int capability(GLenum cap);
+
+    bool update(GLuint& shadow, GLuint value);
+
+    GLuint m_program;
+    GLuint m_vertexArray;
+    std::array<GLuint, BUFFER_TARGET_NUM> m_buffers;
+    std::array<GLuint, MAX_BUFFER_BASES> m_uniformBases;
+    GLuint m_activeTexture;
+    std::array<std::array<GLuint, TEXTURE_TARGET_NUM>, MAX_TEXTURE_UNITS>
+        m_textures;
+    std::array<GLuint, MAX_TEXTURE_UNITS> m_samplers;
+    std::array<GLuint, CAP_NUM> m_caps;
+    GLuint m_blendSrc;
+    GLuint m_blendDst;
+    GLuint m_depthFunc;
+    GLuint m_depthMask;
+    GLuint m_polygonMode;
+    StateCacheStats m_stats{};
+};
+
+} // namespace gl
+} // namespace glrage
\ No newline at end of file
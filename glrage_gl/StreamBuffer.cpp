@@ -0,0 +1,155 @@
+#include "StreamBuffer.hpp"
+
+#include <glrage_util/Logger.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace glrage {
+namespace gl {
+
+StreamBuffer::StreamBuffer(
+    GLenum target, GLsizeiptr segmentSize, uint32_t segments)
+    : Buffer(target)
+    , m_target(target)
+    , m_segmentSize(segmentSize)
+    , m_segments(segments)
+    , m_fences(segments, nullptr)
+{
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    deleteFences();
+}
+
+GLintptr StreamBuffer::upload(
+    const void* data, GLsizeiptr size, GLsizeiptr alignment)
+{
+    // allocate storage on first use and grow the ring if a single upload
+    // doesn't fit into one segment
+    if (!m_allocated || size + alignment > m_segmentSize) {
+        GLsizeiptr segmentSize = m_segmentSize;
+        while (size + alignment > segmentSize) {
+            segmentSize *= 2;
+        }
+        resize(segmentSize);
+    }
+
+    // continue in the next segment if the current one is full
+    GLintptr offset = (m_position + alignment - 1) / alignment * alignment;
+    GLintptr segmentEnd = (m_segment + 1) * m_segmentSize;
+    if (offset + size > segmentEnd) {
+        advance();
+        offset = (m_position + alignment - 1) / alignment * alignment;
+    }
+
+    // the range is guaranteed to be unused by the GPU at this point, so there's
+    // no need to let the driver synchronize the mapping
+    bind();
+    void* dst = glMapBufferRange(m_target, offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+            GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!dst) {
+        throw std::runtime_error("Can't map stream buffer");
+    }
+
+    memcpy(dst, data, size);
+    glUnmapBuffer(m_target);
+
+    m_position = offset + size;
+
+    return offset;
+}
+
+void StreamBuffer::fence()
+{
+    // start a new segment for each frame, unless nothing has been written to
+    // the current one
+    if (m_position > static_cast<GLintptr>(m_segment * m_segmentSize)) {
+        advance();
+    }
+}
+
+uint32_t StreamBuffer::wrapCount()
+{
+    return m_wrapCount;
+}
+
+uint32_t StreamBuffer::waitCount()
+{
+    return m_waitCount;
+}
+
+void StreamBuffer::advance()
+{
+    // protect the segment that has just been filled until the GPU is done
+    // reading from it
+    GLsync& fenceCurrent = m_fences[m_segment];
+    if (fenceCurrent) {
+        glDeleteSync(fenceCurrent);
+    }
+    fenceCurrent = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // move to next segment
+    m_segment = (m_segment + 1) % m_segments;
+    m_position = m_segment * m_segmentSize;
+    if (m_segment == 0) {
+        m_wrapCount++;
+    }
+
+    // wait until the GPU has finished reading the next segment, which should
+    // rarely be the case if there are enough segments
+    GLsync& fenceNext = m_fences[m_segment];
+    if (!fenceNext) {
+        return;
+    }
+
+    if (glClientWaitSync(fenceNext, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        m_waitCount++;
+        LOG_INFO("Stream buffer stall in segment %d (%d total)", m_segment,
+            m_waitCount);
+
+        GLenum result;
+        do {
+            result = glClientWaitSync(
+                fenceNext, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    glDeleteSync(fenceNext);
+    fenceNext = nullptr;
+}
+
+void StreamBuffer::resize(GLsizeiptr segmentSize)
+{
+    if (m_allocated) {
+        LOG_INFO("Stream buffer resize: %d -> %d", m_segmentSize * m_segments,
+            segmentSize * m_segments);
+    }
+
+    // orphan the old storage, the driver will release it once all pending
+    // draw calls are finished, so the fences aren't required anymore
+    deleteFences();
+
+    m_segmentSize = segmentSize;
+    m_segment = 0;
+    m_position = 0;
+    m_allocated = true;
+
+    bind();
+    data(m_segmentSize * m_segments, nullptr, GL_STREAM_DRAW);
+}
+
+void StreamBuffer::deleteFences()
+{
+    for (auto& fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
+
+} // namespace gl
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "gl_core_3_3.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace glrage {
+namespace gl {
+
+// Buffer for streamed data that is written once and drawn once. The buffer is
+// used as a ring that is divided into segments, where each segment is
+// protected by a fence once it has been filled. Data is written with
+// unsynchronized mappings, so the driver never has to wait for pending draw
+// calls unless the ring wraps around faster than the GPU can consume it.
+class StreamBuffer : public Buffer
+{
+public:
+    StreamBuffer(GLenum target, GLsizeiptr segmentSize, uint32_t segments);
+    ~StreamBuffer();
+    GLintptr upload(const void* data, GLsizeiptr size, GLsizeiptr alignment);
+    void fence();
+    uint32_t wrapCount();
+    uint32_t waitCount();
+
+private:
+    static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+    void advance();
+    void resize(GLsizeiptr segmentSize);
+    void deleteFences();
+
+    GLenum m_target;
+    GLsizeiptr m_segmentSize;
+    uint32_t m_segments;
+    uint32_t m_segment = 0;
+    GLintptr m_position = 0;
+    bool m_allocated = false;
+    std::vector<GLsync> m_fences;
+    uint32_t m_wrapCount = 0;
+    uint32_t m_waitCount = 0;
+};
+
+} // namespace gl
+} // namespace glrage
\ No newline at end of file
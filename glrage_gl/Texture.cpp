@@ -1,4 +1,5 @@
 #include "Texture.hpp"
+#include "StateCache.hpp"
 
 namespace glrage {
 namespace gl {
@@ -12,11 +13,12 @@ Texture::Texture(GLenum target)
 Texture::~Texture()
 {
     glDeleteTextures(1, &m_id);
+    StateCache::current().textureDeleted(m_id);
 }
 
 void Texture::bind()
 {
-    glBindTexture(m_target, m_id);
+    StateCache::current().bindTexture(m_target, m_id);
 }
 
 GLenum Texture::target()
@@ -0,0 +1,34 @@
+#include "Uniform.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace glrage {
+namespace gl {
+
+void applyUniform(GLint location, const GLint& value)
+{
+    glUniform1i(location, value);
+}
+
+void applyUniform(GLint location, const GLfloat& value)
+{
+    glUniform1f(location, value);
+}
+
+void applyUniform(GLint location, const glm::vec3& value)
+{
+    glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void applyUniform(GLint location, const glm::vec4& value)
+{
+    glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+void applyUniform(GLint location, const glm::mat4& value)
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+} // namespace gl
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "gl_core_3_3.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+namespace glrage {
+namespace gl {
+
+// counters of uniform updates, shared by all uniforms of a program
+struct UniformStats
+{
+    uint32_t issued;
+    uint32_t skipped;
+};
+
+void applyUniform(GLint location, const GLint& value);
+void applyUniform(GLint location, const GLfloat& value);
+void applyUniform(GLint location, const glm::vec3& value);
+void applyUniform(GLint location, const glm::vec4& value);
+void applyUniform(GLint location, const glm::mat4& value);
+
+// Typed handle of a uniform with a shadow copy of its last value. The location
+// is resolved once and updates that wouldn't change the value are skipped.
+// Like the uniform functions of Program, it requires the program to be bound.
+template <typename T> class Uniform
+{
+public:
+    Uniform() = default;
+
+    Uniform(GLint location, UniformStats* stats)
+        : m_location(location)
+        , m_stats(stats)
+    {
+    }
+
+    bool set(const T& value)
+    {
+        if (m_location == -1) {
+            return false;
+        }
+
+        if (m_valid && memcmp(&m_value, &value, sizeof(T)) == 0) {
+            m_stats->skipped++;
+            return false;
+        }
+
+        applyUniform(m_location, value);
+        m_value = value;
+        m_valid = true;
+        m_stats->issued++;
+        return true;
+    }
+
+    // forget the shadow copy, for example after the program was relinked
+    void invalidate()
+    {
+        m_valid = false;
+    }
+
+private:
+    GLint m_location = -1;
+    UniformStats* m_stats = nullptr;
+    T m_value{};
+    bool m_valid = false;
+};
+
+} // namespace gl
+} // namespace glrage
\ No newline at end of file
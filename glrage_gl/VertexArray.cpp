@@ -1,4 +1,5 @@
 #include "VertexArray.hpp"
+#include "StateCache.hpp"
 
 namespace glrage {
 namespace gl {
@@ -11,11 +12,12 @@ VertexArray::VertexArray()
 VertexArray::~VertexArray()
 {
     glDeleteVertexArrays(1, &m_id);
+    StateCache::current().vertexArrayDeleted(m_id);
 }
 
 void VertexArray::bind()
 {
-    glBindVertexArray(m_id);
+    StateCache::current().bindVertexArray(m_id);
 }
 
 void VertexArray::attribute(GLuint index, GLint size, GLenum type,
@@ -26,5 +28,13 @@ void VertexArray::attribute(GLuint index, GLint size, GLenum type,
         index, size, type, normalized, stride, reinterpret_cast<void*>(offset));
 }
 
+void VertexArray::attributeInteger(
+    GLuint index, GLint size, GLenum type, GLsizei stride, GLsizei offset)
+{
+    glEnableVertexAttribArray(index);
+    glVertexAttribIPointer(
+        index, size, type, stride, reinterpret_cast<void*>(offset));
+}
+
 } // namespace gl
 } // namespace glrage
\ No newline at end of file
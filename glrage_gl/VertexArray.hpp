@@ -14,6 +14,8 @@ public:
     void bind();
     void attribute(GLuint index, GLint size, GLenum type, GLboolean normalized,
         GLsizei stride, GLsizei offset);
+    void attributeInteger(GLuint index, GLint size, GLenum type,
+        GLsizei stride, GLsizei offset);
 };
 
 } // namespace gl
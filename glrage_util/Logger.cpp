@@ -1,8 +1,18 @@
 #include "Logger.hpp"
 
+#include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <string>
 
+#ifndef _WIN32
+// the tests also run on other platforms, which log to stderr
+#define vsnprintf_s(buffer, size, count, format, list)                         \
+    vsnprintf(buffer, size, format, list)
+#define strnlen_s strnlen
+#define OutputDebugStringA(output) fputs(output, stderr)
+#endif
+
 static const size_t bufferSize = 1024;
 
 void Logger::printf(const char* format, ...)
@@ -1,7 +1,9 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <intrin.h>
+#endif
 
 #include <string>
 
@@ -0,0 +1,165 @@
+#include "RenderThread.hpp"
+#include "Logger.hpp"
+
+#include <exception>
+#include <future>
+#include <stdexcept>
+
+namespace glrage {
+
+RenderThread& RenderThread::instance()
+{
+    static RenderThread instance;
+    return instance;
+}
+
+RenderThread::~RenderThread()
+{
+    // The thread is stopped by the context when the last CIF or DirectDraw
+    // instance is released. If it's still running here, the process is being
+    // terminated, which has already killed the thread, so waiting for it would
+    // never return.
+    if (active()) {
+        m_thread.detach();
+    }
+}
+
+void RenderThread::start(uint32_t depth)
+{
+    if (active()) {
+        return;
+    }
+
+    // round up to a power of two, so the ring positions can be masked
+    size_t size = 2;
+    while (size < depth) {
+        size <<= 1;
+    }
+
+    m_ring.clear();
+    m_ring.resize(size);
+    m_mask = size - 1;
+    m_head = 0;
+    m_tail = 0;
+    m_running = true;
+    m_thread = std::thread(&RenderThread::run, this);
+
+    LOG_INFO("Render thread started with a queue depth of %u",
+        static_cast<uint32_t>(size));
+}
+
+void RenderThread::stop()
+{
+    if (!active()) {
+        return;
+    }
+
+    // let the thread finish all pending commands first
+    sync();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool RenderThread::active()
+{
+    return m_thread.joinable();
+}
+
+bool RenderThread::current()
+{
+    return std::this_thread::get_id() == m_thread.get_id();
+}
+
+void RenderThread::post(Command command)
+{
+    if (!active() || current()) {
+        command();
+        return;
+    }
+
+    // wait for the render thread to make room if the queue is full, which
+    // limits how far the application can get ahead
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    while (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+        std::this_thread::yield();
+    }
+
+    m_ring[tail & m_mask] = std::move(command);
+    m_tail.store(tail + 1);
+
+    // the render thread only sleeps if it has seen an empty queue
+    if (m_waiting.load()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wake.notify_one();
+    }
+}
+
+void RenderThread::call(const Command& command)
+{
+    if (!active() || current()) {
+        command();
+        return;
+    }
+
+    // errors are passed back to the calling thread
+    std::promise<void> done;
+    post([&command, &done] {
+        try {
+            command();
+            done.set_value();
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    });
+
+    done.get_future().get();
+}
+
+void RenderThread::sync()
+{
+    call([] {});
+}
+
+void RenderThread::run()
+{
+    while (true) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_waiting = true;
+            m_wake.wait(lock, [this, head] {
+                return head != m_tail.load() || !m_running;
+            });
+            m_waiting = false;
+
+            if (head == m_tail.load()) {
+                break;
+            }
+        }
+
+        // free the slot before the producer is allowed to reuse it
+        Command command = std::move(m_ring[head & m_mask]);
+        m_ring[head & m_mask] = nullptr;
+        m_head.store(head + 1, std::memory_order_release);
+
+        execute(command);
+    }
+}
+
+void RenderThread::execute(Command& command)
+{
+    // there's nobody to report errors of asynchronous commands to
+    try {
+        command();
+    } catch (const std::exception& ex) {
+        LOG_INFO("Render command failed: %s", ex.what());
+    }
+}
+
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace glrage {
+
+// Optional thread that owns the GL context and executes the commands of the
+// application threads in order. Commands are passed through a bounded
+// single-producer/single-consumer ring, so they must be posted from one thread
+// only and must own copies of all data they reference. If the thread isn't
+// running, or commands are posted by the render thread itself, they are
+// executed immediately. The thread has to be stopped before the process exits,
+// as it can't be joined during process termination.
+class RenderThread
+{
+public:
+    typedef std::function<void()> Command;
+
+    static RenderThread& instance();
+
+    ~RenderThread();
+    void start(uint32_t depth);
+    void stop();
+    bool active();
+    bool current();
+    void post(Command command);
+    void call(const Command& command);
+    void sync();
+
+private:
+    RenderThread(){};
+    RenderThread(RenderThread const&) = delete;
+    void operator=(RenderThread const&) = delete;
+
+    void run();
+    void execute(Command& command);
+
+    std::vector<Command> m_ring;
+    size_t m_mask{0};
+    std::atomic<size_t> m_head{0};
+    std::atomic<size_t> m_tail{0};
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_waiting{false};
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+};
+
+} // namespace glrage
\ No newline at end of file
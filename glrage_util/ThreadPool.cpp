@@ -0,0 +1,134 @@
+#include "ThreadPool.hpp"
+#include "Logger.hpp"
+
+namespace glrage {
+
+ThreadPool::ThreadPool(uint32_t threads)
+{
+    if (threads == 0) {
+        uint32_t hardware = std::thread::hardware_concurrency();
+        threads = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    for (uint32_t i = 0; i < threads; i++) {
+        m_threads.emplace_back(&ThreadPool::work, this);
+    }
+
+    LOG_INFO("Thread pool started with %u workers", threads);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+uint32_t ThreadPool::size()
+{
+    return static_cast<uint32_t>(m_threads.size()) + 1;
+}
+
+void ThreadPool::run(uint32_t count, const Task& task)
+{
+    // not worth waking up the workers
+    if (count <= 1 || m_threads.empty()) {
+        for (uint32_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_pending = count;
+        m_next = 0;
+        m_error = nullptr;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    execute(task, count);
+
+    // workers may still be running the last tasks
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending == 0 && m_active == 0; });
+        m_task = nullptr;
+        error = m_error;
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::work()
+{
+    uint64_t generation = 0;
+
+    while (true) {
+        const Task* task;
+        uint32_t count;
+        {
+            // jobs that were finished before this worker woke up are skipped
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, generation] {
+                return m_stop ||
+                       (m_generation != generation && m_pending > 0);
+            });
+
+            if (m_stop) {
+                return;
+            }
+
+            generation = m_generation;
+            task = m_task;
+            count = m_count;
+            m_active++;
+        }
+
+        execute(*task, count);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_active--;
+        }
+        m_done.notify_one();
+    }
+}
+
+void ThreadPool::execute(const Task& task, uint32_t count)
+{
+    for (uint32_t i = m_next++; i < count; i = m_next++) {
+        try {
+            task(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error) {
+                m_error = std::current_exception();
+            }
+        }
+
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            done = --m_pending == 0;
+        }
+
+        if (done) {
+            m_done.notify_one();
+        }
+    }
+}
+
+} // namespace glrage
\ No newline at end of file
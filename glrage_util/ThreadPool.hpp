@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace glrage {
+
+// Fixed set of worker threads for data parallel jobs. The calling thread
+// works on the job as well and only returns once all of its tasks are done,
+// so tasks may reference data on the caller's stack.
+class ThreadPool
+{
+public:
+    typedef std::function<void(uint32_t)> Task;
+
+    // zero threads use one worker less than there are hardware threads
+    ThreadPool(uint32_t threads);
+    ~ThreadPool();
+    uint32_t size();
+    void run(uint32_t count, const Task& task);
+
+private:
+    ThreadPool(ThreadPool const&) = delete;
+    void operator=(ThreadPool const&) = delete;
+
+    void work();
+    void execute(const Task& task, uint32_t count);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Task* m_task{nullptr};
+    uint32_t m_count{0};
+    uint32_t m_pending{0};
+    uint32_t m_active{0};
+    uint64_t m_generation{0};
+    bool m_stop{false};
+    std::atomic<uint32_t> m_next{0};
+    std::exception_ptr m_error;
+};
+
+} // namespace glrage
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace glrage {
+namespace test {
+
+// Calls func in rounds of the given number of iterations for a quarter of a
+// second and returns the fastest round in nanoseconds per call.
+template <typename Func> double measure(uint32_t iterations, Func func)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double best = 0;
+    auto end = Clock::now() + std::chrono::milliseconds(250);
+    do {
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            func();
+        }
+        std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+
+        double time = elapsed.count() / iterations;
+        if (best == 0 || time < best) {
+            best = time;
+        }
+    } while (Clock::now() < end);
+
+    return best;
+}
+
+} // namespace test
+} // namespace glrage
\ No newline at end of file
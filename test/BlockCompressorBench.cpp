@@ -0,0 +1,336 @@
+#include "Bench.hpp"
+
+#include <ati3dcif/BlockCompressor.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace glrage;
+using namespace glrage::cif;
+
+namespace {
+
+struct Image
+{
+    std::string name;
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint32_t> texels;
+};
+
+inline uint32_t channel(uint32_t texel, uint32_t shift)
+{
+    return texel >> shift & 0xff;
+}
+
+inline uint32_t rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return r | g << 8 | b << 16 | a << 24;
+}
+
+uint32_t levelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+// appends all smaller levels with a 2x2 box filter, like MipmapBuilder
+std::vector<uint32_t> buildChain(const Image& image)
+{
+    std::vector<uint32_t> chain = image.texels;
+    uint32_t width = image.width;
+    uint32_t height = image.height;
+    size_t offset = 0;
+
+    for (uint32_t level = 1; level < levelCount(width, height); level++) {
+        uint32_t srcWidth = std::max(1u, width >> (level - 1));
+        uint32_t srcHeight = std::max(1u, height >> (level - 1));
+        uint32_t dstWidth = std::max(1u, width >> level);
+        uint32_t dstHeight = std::max(1u, height >> level);
+
+        size_t dstOffset = chain.size();
+        chain.resize(dstOffset + dstWidth * dstHeight);
+        for (uint32_t y = 0; y < dstHeight; y++) {
+            for (uint32_t x = 0; x < dstWidth; x++) {
+                uint32_t sx = std::min(x * 2, srcWidth - 1);
+                uint32_t sy = std::min(y * 2, srcHeight - 1);
+                uint32_t sx1 = std::min(sx + 1, srcWidth - 1);
+                uint32_t sy1 = std::min(sy + 1, srcHeight - 1);
+                const uint32_t* src = &chain[offset];
+                uint32_t quad[] = {src[sy * srcWidth + sx],
+                    src[sy * srcWidth + sx1], src[sy1 * srcWidth + sx],
+                    src[sy1 * srcWidth + sx1]};
+
+                uint32_t texel = 0;
+                for (uint32_t shift = 0; shift < 32; shift += 8) {
+                    uint32_t sum = 2;
+                    for (uint32_t q : quad) {
+                        sum += channel(q, shift);
+                    }
+                    texel |= (sum / 4) << shift;
+                }
+                chain[dstOffset + y * dstWidth + x] = texel;
+            }
+        }
+        offset = dstOffset;
+    }
+
+    return chain;
+}
+
+inline void unpack565(uint16_t c, uint32_t* rgb)
+{
+    uint32_t r = c >> 11 & 31;
+    uint32_t g = c >> 5 & 63;
+    uint32_t b = c & 31;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+}
+
+// decodes the color part like the GPU does, BC3 blocks always use four colors
+void decodeColor(const uint8_t* block, bool fourColors, uint32_t* texels)
+{
+    uint16_t c0 = static_cast<uint16_t>(block[0] | block[1] << 8);
+    uint16_t c1 = static_cast<uint16_t>(block[2] | block[3] << 8);
+
+    uint32_t palette[4][3];
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+
+    bool transparent = !fourColors && c0 <= c1;
+    for (uint32_t c = 0; c < 3; c++) {
+        if (transparent) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        } else {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t index = block[4 + i / 4] >> (i % 4 * 2) & 3;
+        uint32_t alpha = transparent && index == 3 ? 0 : 255;
+        texels[i] = rgba(palette[index][0], palette[index][1],
+            palette[index][2], alpha);
+    }
+}
+
+void decodeAlpha(const uint8_t* block, uint32_t* texels)
+{
+    uint32_t a0 = block[0];
+    uint32_t a1 = block[1];
+
+    uint32_t values[8] = {a0, a1};
+    if (a0 > a1) {
+        for (uint32_t i = 1; i < 7; i++) {
+            values[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        }
+    } else {
+        for (uint32_t i = 1; i < 5; i++) {
+            values[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        }
+        values[6] = 0;
+        values[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (uint32_t i = 0; i < 6; i++) {
+        indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+    }
+
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t alpha = values[indices >> (i * 3) & 7];
+        texels[i] = (texels[i] & 0xffffff) | alpha << 24;
+    }
+}
+
+// decodes the first level of the compressed chain
+std::vector<uint32_t> decode(const std::vector<uint8_t>& blocks,
+    uint32_t width, uint32_t height, TextureFormat format)
+{
+    std::vector<uint32_t> texels(width * height);
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t blockSize = format == TEXTURE_BC1 ? 8 : 16;
+
+    for (uint32_t by = 0; by < height; by += 4) {
+        for (uint32_t bx = 0; bx < width; bx += 4) {
+            const uint8_t* block =
+                &blocks[((by / 4) * blocksX + bx / 4) * blockSize];
+
+            uint32_t decoded[16];
+            if (format == TEXTURE_BC1) {
+                decodeColor(block, false, decoded);
+            } else {
+                decodeColor(block + 8, true, decoded);
+                decodeAlpha(block, decoded);
+            }
+
+            for (uint32_t y = 0; y < 4 && by + y < height; y++) {
+                for (uint32_t x = 0; x < 4 && bx + x < width; x++) {
+                    texels[(by + y) * width + bx + x] = decoded[y * 4 + x];
+                }
+            }
+        }
+    }
+
+    return texels;
+}
+
+// Errors of the first level. Colors are compared where the source is visible,
+// BC1 transparency counts as wrong if it doesn't match the alpha threshold.
+void compare(const Image& image, const std::vector<uint32_t>& decoded,
+    TextureFormat format, double& rmseColor, double& rmseAlpha)
+{
+    double sumColor = 0;
+    double sumAlpha = 0;
+    size_t visible = 0;
+
+    for (size_t i = 0; i < image.texels.size(); i++) {
+        uint32_t src = image.texels[i];
+        uint32_t dst = decoded[i];
+
+        double alpha = static_cast<double>(channel(src, 24));
+        if (format == TEXTURE_BC1) {
+            alpha = alpha < 128 ? 0 : 255;
+        }
+        double d = alpha - channel(dst, 24);
+        sumAlpha += d * d;
+
+        if (channel(src, 24) >= 128) {
+            for (uint32_t shift = 0; shift < 24; shift += 8) {
+                double c = static_cast<double>(channel(src, shift)) -
+                           channel(dst, shift);
+                sumColor += c * c;
+            }
+            visible++;
+        }
+    }
+
+    rmseColor = visible ? std::sqrt(sumColor / (visible * 3)) : 0;
+    rmseAlpha = std::sqrt(sumAlpha / image.texels.size());
+}
+
+// Synthetic textures: smooth gradients with some noise, like most game
+// textures, a cutout sprite for BC1 transparency and a smooth alpha channel
+// for BC3.
+std::vector<Image> syntheticImages()
+{
+    const uint32_t size = 256;
+    std::mt19937 random(1);
+    std::vector<Image> images;
+
+    Image gradient{"gradient", size, size, {}};
+    Image cutout{"cutout", size, size, {}};
+    Image alpha{"alpha", size, size, {}};
+    Image noise{"noise", size, size, {}};
+
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            uint32_t n = random() % 16;
+            uint32_t r = std::min(255u, x + n);
+            uint32_t g = std::min(255u, y + n);
+            uint32_t b = std::min(255u, (x + y) / 2 + n);
+            gradient.texels.push_back(rgba(r, g, b, 255));
+
+            // circles on a transparent background
+            int32_t dx = static_cast<int32_t>(x % 64) - 32;
+            int32_t dy = static_cast<int32_t>(y % 64) - 32;
+            bool inside = dx * dx + dy * dy < 28 * 28;
+            cutout.texels.push_back(rgba(r, g, b, inside ? 255 : 0));
+
+            alpha.texels.push_back(rgba(r, g, b, (x + y) / 2));
+
+            uint32_t texel = random();
+            noise.texels.push_back(texel | 0xff000000);
+        }
+    }
+
+    images.push_back(gradient);
+    images.push_back(cutout);
+    images.push_back(alpha);
+    images.push_back(noise);
+    return images;
+}
+
+// raw RGBA8 texels, as written by image editors or dumped from the texture
+// cache
+bool loadImage(const char* path, uint32_t width, uint32_t height, Image& image)
+{
+    std::ifstream file(path, std::ios::binary);
+    image = {path, width, height, std::vector<uint32_t>(width * height)};
+    file.read(reinterpret_cast<char*>(&image.texels[0]),
+        image.texels.size() * 4);
+    return file.good();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<Image> images;
+    if (argc == 4) {
+        Image image;
+        uint32_t width = std::atoi(argv[2]);
+        uint32_t height = std::atoi(argv[3]);
+        if (width == 0 || height == 0 ||
+            !loadImage(argv[1], width, height, image)) {
+            std::printf("can't read %ux%u RGBA8 texels from %s\n", width,
+                height, argv[1]);
+            return 1;
+        }
+        images.push_back(image);
+    } else if (argc == 1) {
+        images = syntheticImages();
+    } else {
+        std::printf("usage: %s [<raw RGBA8 file> <width> <height>]\n", argv[0]);
+        return 1;
+    }
+
+    // sized like the pool of the renderer, the calling thread works as well
+    ThreadPool pool(0);
+    BlockCompressor compressor(pool);
+    std::printf("encoding with %u threads\n", pool.size());
+
+    std::printf("%-10s %-6s %10s %10s %12s\n", "image", "format",
+        "rmse rgb", "rmse a", "Mtexels/s");
+
+    for (const Image& image : images) {
+        std::vector<uint32_t> chain = buildChain(image);
+        TextureFormat format = BlockCompressor::selectFormat(
+            &image.texels[0], image.texels.size());
+        std::vector<uint8_t> blocks(
+            BlockCompressor::chainSize(image.width, image.height, format));
+
+        auto compress = [&] {
+            compressor.compress(reinterpret_cast<const uint8_t*>(&chain[0]),
+                image.width, image.height, format, &blocks[0]);
+        };
+        compress();
+
+        double rmseColor;
+        double rmseAlpha;
+        std::vector<uint32_t> decoded =
+            decode(blocks, image.width, image.height, format);
+        compare(image, decoded, format, rmseColor, rmseAlpha);
+
+        double time = test::measure(1, compress);
+        double throughput = chain.size() / time * 1000;
+
+        std::printf("%-10s %-6s %10.2f %10.2f %12.1f\n", image.name.c_str(),
+            format == TEXTURE_BC1 ? "BC1" : "BC3", rmseColor, rmseAlpha,
+            throughput);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "Bench.hpp"
+
+#include <ati3dcif/Indices.hpp>
+
+#include <cstdio>
+#include <vector>
+
+using namespace glrage;
+using namespace glrage::cif;
+
+namespace {
+
+// Triangulates quad strips with a scalar push_back loop like the one used for
+// quads in meshes, then narrows the indices like the batch upload did before.
+void emitScalar(const std::vector<uint32_t>& strips,
+    std::vector<uint32_t>& indices, std::vector<uint16_t>& indices16)
+{
+    indices.clear();
+
+    uint32_t base = 0;
+    for (uint32_t numVert : strips) {
+        for (uint32_t i = 0; i + 3 < numVert; i += 2) {
+            indices.push_back(base + i);
+            indices.push_back(base + i + 1);
+            indices.push_back(base + i + 2);
+
+            indices.push_back(base + i + 1);
+            indices.push_back(base + i + 3);
+            indices.push_back(base + i + 2);
+        }
+        base += numVert;
+    }
+
+    indices16.assign(indices.begin(), indices.end());
+}
+
+// rebases a prefix of the cached quad strip indices per strip, like the
+// vertex stream does
+void emitKernel(const std::vector<uint32_t>& strips,
+    const std::vector<uint32_t>& cached, std::vector<uint32_t>& indices,
+    std::vector<uint16_t>& indices16)
+{
+    indices.clear();
+
+    uint32_t base = 0;
+    for (uint32_t numVert : strips) {
+        size_t offset = indices.size();
+        size_t numIndices = numVert > 3 ? (numVert - 2) / 2 * 6 : 0;
+        indices.resize(offset + numIndices);
+        rebaseIndices(&cached[0], numIndices, base, &indices[offset]);
+        base += numVert;
+    }
+
+    indices16.resize(indices.size());
+    narrowIndices(&indices[0], indices.size(), &indices16[0]);
+}
+
+} // namespace
+
+int main()
+{
+    // a batch of strips with typical lengths, small enough for 16 bit indices
+    const uint32_t lengths[] = {4, 6, 10, 18, 34, 66};
+    std::vector<uint32_t> strips;
+    uint32_t numVert = 0;
+    for (uint32_t i = 0; numVert < 16384; i++) {
+        strips.push_back(lengths[i % 6]);
+        numVert += strips.back();
+    }
+
+    std::vector<uint32_t> cached;
+    for (uint32_t i = 0; i + 3 < 66; i += 2) {
+        uint32_t quad[] = {i, i + 1, i + 2, i + 1, i + 3, i + 2};
+        cached.insert(cached.end(), quad, quad + 6);
+    }
+
+    std::vector<uint32_t> scalar, kernel;
+    std::vector<uint16_t> scalar16, kernel16;
+    emitScalar(strips, scalar, scalar16);
+    emitKernel(strips, cached, kernel, kernel16);
+    if (scalar16 != kernel16) {
+        std::printf("index kernels don't match the scalar loop\n");
+        return 1;
+    }
+
+    double timeScalar =
+        test::measure(100, [&] { emitScalar(strips, scalar, scalar16); });
+    double timeKernel = test::measure(
+        100, [&] { emitKernel(strips, cached, kernel, kernel16); });
+
+    double count = static_cast<double>(scalar16.size());
+    std::printf("%u quad strips, %u vertices, %u indices per batch\n",
+        static_cast<uint32_t>(strips.size()), numVert,
+        static_cast<uint32_t>(scalar16.size()));
+    std::printf("scalar push_back: %8.1f us, %.2f ns per index\n",
+        timeScalar / 1000, timeScalar / count);
+    std::printf("index kernels:    %8.1f us, %.2f ns per index (%.1fx)\n",
+        timeKernel / 1000, timeKernel / count, timeScalar / timeKernel);
+
+    return 0;
+}
\ No newline at end of file
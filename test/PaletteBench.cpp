@@ -0,0 +1,119 @@
+#include "Bench.hpp"
+
+#include <ati3dcif/Palette.hpp>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace glrage;
+using namespace glrage::cif;
+
+namespace {
+
+// 256x256 CI8 atlases with all levels down to 1x1
+const uint32_t ATLAS_SIZE = 256;
+const uint32_t NUM_ATLASES = 16;
+
+std::vector<uint32_t> levelSizes()
+{
+    std::vector<uint32_t> sizes;
+    for (uint32_t size = ATLAS_SIZE; size > 0; size >>= 1) {
+        sizes.push_back(size * size);
+    }
+    return sizes;
+}
+
+// expands the atlases level by level, like the texture upload does
+template <typename Expand>
+void expandAtlases(Expand expand, const std::vector<uint32_t>& levels,
+    const std::vector<uint8_t>& src, std::vector<uint32_t>& dst)
+{
+    size_t offset = 0;
+    for (uint32_t atlas = 0; atlas < NUM_ATLASES; atlas++) {
+        for (uint32_t count : levels) {
+            expand(&src[offset], count, &dst[offset]);
+            offset += count;
+        }
+    }
+}
+
+} // namespace
+
+int main()
+{
+    std::vector<uint32_t> levels = levelSizes();
+    size_t texels = 0;
+    for (uint32_t count : levels) {
+        texels += count;
+    }
+    texels *= NUM_ATLASES;
+
+    std::mt19937 random(1);
+    C3D_PALETTENTRY entries[Palette::SIZE];
+    for (auto& entry : entries) {
+        entry.r = random() & 0xff;
+        entry.g = random() & 0xff;
+        entry.b = random() & 0xff;
+        entry.flags = 0;
+    }
+    Palette palette(entries);
+    const uint32_t* table = &palette.table()[0];
+
+    std::vector<uint8_t> src(texels);
+    for (auto& index : src) {
+        index = random() & 0xff;
+    }
+
+    auto scalar = [table](const uint8_t* src, size_t count, uint32_t* dst) {
+        expandScalar(table, src, count, dst);
+    };
+    auto avx2 = [table](const uint8_t* src, size_t count, uint32_t* dst) {
+        expandAVX2(table, src, count, dst);
+    };
+    auto dispatched = [&palette](const uint8_t* src, size_t count,
+                          uint32_t* dst) { palette.expand(src, count, dst); };
+
+    std::vector<uint32_t> expected(texels), dst(texels);
+    expandAtlases(scalar, levels, src, expected);
+
+    double count = static_cast<double>(texels);
+    std::printf("%u CI8 atlases of %ux%u with %u levels, %u texels\n",
+        NUM_ATLASES, ATLAS_SIZE, ATLAS_SIZE,
+        static_cast<uint32_t>(levels.size()), static_cast<uint32_t>(texels));
+
+    double timeScalar =
+        test::measure(10, [&] { expandAtlases(scalar, levels, src, dst); });
+    std::printf("scalar:          %8.1f us, %.2f ns per texel\n",
+        timeScalar / 1000, timeScalar / count);
+
+    if (hasAVX2()) {
+        expandAtlases(avx2, levels, src, dst);
+        if (dst != expected) {
+            std::printf("AVX2 kernel doesn't match the scalar loop\n");
+            return 1;
+        }
+
+        double timeAVX2 =
+            test::measure(10, [&] { expandAtlases(avx2, levels, src, dst); });
+        std::printf("AVX2:            %8.1f us, %.2f ns per texel (%.1fx)\n",
+            timeAVX2 / 1000, timeAVX2 / count, timeScalar / timeAVX2);
+    } else {
+        std::printf("AVX2:            not supported by this CPU\n");
+    }
+
+    // the kernel Palette::expand picked for this CPU, including the dispatch
+    expandAtlases(dispatched, levels, src, dst);
+    if (dst != expected) {
+        std::printf("Palette::expand doesn't match the scalar loop\n");
+        return 1;
+    }
+
+    double timeDispatched =
+        test::measure(10, [&] { expandAtlases(dispatched, levels, src, dst); });
+    std::printf("Palette::expand: %8.1f us, %.2f ns per texel (%.1fx)\n",
+        timeDispatched / 1000, timeDispatched / count,
+        timeScalar / timeDispatched);
+
+    return 0;
+}
\ No newline at end of file
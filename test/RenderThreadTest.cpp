@@ -0,0 +1,179 @@
+#include "Test.hpp"
+
+#include <glrage_util/RenderThread.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace glrage;
+
+namespace {
+
+RenderThread& renderThread = RenderThread::instance();
+
+// commands are executed by the render thread in the order they were posted
+void testOrder()
+{
+    renderThread.start(64);
+    CHECK(renderThread.active());
+    CHECK(!renderThread.current());
+
+    std::vector<uint32_t> order;
+    bool current = true;
+    for (uint32_t i = 0; i < 10000; i++) {
+        renderThread.post([&order, &current, i] {
+            order.push_back(i);
+            current = current && renderThread.current();
+        });
+    }
+    renderThread.sync();
+
+    CHECK(order.size() == 10000);
+    for (uint32_t i = 0; i < order.size(); i++) {
+        CHECK(order[i] == i);
+    }
+    CHECK(current);
+
+    renderThread.stop();
+}
+
+// the producer has to wait once the configured number of commands is queued
+void testBackpressure()
+{
+    const uint32_t depth = 8;
+    renderThread.start(depth);
+
+    std::promise<void> started;
+    std::promise<void> gate;
+    std::shared_future<void> gateOpen = gate.get_future().share();
+    std::atomic<uint32_t> queued{0};
+    std::atomic<uint32_t> executed{0};
+    std::atomic<bool> blocked{true};
+
+    // the render thread is kept busy by the first command, so the queue fills
+    // up behind it
+    std::thread producer([&] {
+        renderThread.post([&started, gateOpen] {
+            started.set_value();
+            gateOpen.wait();
+        });
+        started.get_future().wait();
+
+        for (uint32_t i = 0; i < depth; i++) {
+            renderThread.post([&executed] { executed++; });
+            queued++;
+        }
+
+        renderThread.post([&executed] { executed++; });
+        blocked = false;
+    });
+
+    while (queued < depth) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(blocked);
+    CHECK(executed == 0);
+
+    gate.set_value();
+    producer.join();
+    CHECK(!blocked);
+
+    renderThread.sync();
+    CHECK(executed == depth + 1);
+
+    renderThread.stop();
+}
+
+// errors of synchronous commands are passed to the caller, errors of
+// asynchronous commands don't stop the thread
+void testExceptions()
+{
+    renderThread.start(16);
+
+    bool caught = false;
+    try {
+        renderThread.call([] { throw std::runtime_error("command failed"); });
+    } catch (const std::runtime_error& ex) {
+        caught = std::string(ex.what()) == "command failed";
+    }
+    CHECK(caught);
+
+    renderThread.post([] { throw std::runtime_error("ignored"); });
+
+    bool executed = false;
+    renderThread.call([&executed] { executed = true; });
+    CHECK(executed);
+
+    renderThread.stop();
+}
+
+// The render thread goes to sleep whenever the queue runs empty. A lost wakeup
+// would leave a command in the queue and hang the following call, which is
+// caught by the test timeout.
+void testWakeup()
+{
+    renderThread.start(16);
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < 10000; i++) {
+        if (i % 4 == 1) {
+            std::this_thread::yield();
+        } else if (i % 4 == 2) {
+            std::this_thread::sleep_for(std::chrono::microseconds(i % 50));
+        }
+
+        renderThread.post([&count] { count++; });
+        if (i % 2 == 0) {
+            renderThread.sync();
+            CHECK(count == i + 1);
+        }
+    }
+
+    renderThread.sync();
+    CHECK(count == 10000);
+
+    renderThread.stop();
+}
+
+// stopping finishes all pending commands, afterwards commands are executed
+// immediately by the calling thread
+void testStop()
+{
+    renderThread.start(1024);
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        renderThread.post([&count] {
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            count++;
+        });
+    }
+
+    renderThread.stop();
+    CHECK(!renderThread.active());
+    CHECK(count == 1000);
+
+    renderThread.post([&count] { count++; });
+    CHECK(count == 1001);
+
+    // stopping twice is harmless
+    renderThread.stop();
+}
+
+} // namespace
+
+int main()
+{
+    testOrder();
+    testBackpressure();
+    testExceptions();
+    testWakeup();
+    testStop();
+    return glrage::test::failures() != 0;
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "Bench.hpp"
+
+#include <ati3dcif/State.hpp>
+
+#include <bitset>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace glrage;
+using namespace glrage::cif;
+using namespace std::placeholders;
+
+namespace {
+
+// the states the renderer reacts to
+const C3D_ERSID DRAW_STATES[] = {C3D_ERS_VERTEX_TYPE, C3D_ERS_PRIM_TYPE,
+    C3D_ERS_SOLID_CLR, C3D_ERS_SHADE_MODE, C3D_ERS_TMAP_EN,
+    C3D_ERS_TMAP_SELECT, C3D_ERS_TMAP_LIGHT, C3D_ERS_TMAP_FILTER,
+    C3D_ERS_TMAP_TEXOP, C3D_ERS_ALPHA_SRC, C3D_ERS_ALPHA_DST,
+    C3D_ERS_Z_CMP_FNC, C3D_ERS_Z_MODE};
+const uint32_t NUM_DRAW_STATES = sizeof(DRAW_STATES) / sizeof(C3D_ERSID);
+
+size_t valueSize(C3D_ERSID id)
+{
+    switch (id) {
+        case C3D_ERS_SOLID_CLR:
+            return sizeof(C3D_COLOR);
+        case C3D_ERS_TMAP_SELECT:
+            return sizeof(C3D_HTX);
+        default:
+            return sizeof(C3D_UINT32);
+    }
+}
+
+// The state variables as they were before: every write is copied into a
+// temporary value and every change notifies a list of std::function
+// observers.
+class ObserverVar
+{
+public:
+    typedef std::function<void(StateVar::Value&)> Observer;
+
+    explicit ObserverVar(size_t size) : m_size(size)
+    {
+    }
+
+    void set(C3D_PRSDATA pRStateData)
+    {
+        StateVar::Value valueTmp{0};
+        memcpy(&valueTmp.raw[0], pRStateData, m_size);
+        set(valueTmp);
+    }
+
+    void set(const StateVar::Value& value)
+    {
+        if (m_value.raw != value.raw) {
+            m_value = value;
+            notify();
+        }
+    }
+
+    void registerObserver(const Observer& observer)
+    {
+        m_observers.push_back(observer);
+    }
+
+private:
+    void notify()
+    {
+        for (auto& observer : m_observers) {
+            observer(m_value);
+        }
+    }
+
+    size_t m_size;
+    StateVar::Value m_value{0};
+    std::vector<Observer> m_observers;
+};
+
+// The renderer before: each draw state switches the state, then runs its own
+// handler. The handlers only record their value, the GL calls they made are
+// not part of the measurement.
+class ObserverRenderer
+{
+public:
+    ObserverRenderer()
+    {
+        for (int32_t id = 0; id < C3D_ERS_NUM; id++) {
+            m_vars.emplace_back(valueSize(static_cast<C3D_ERSID>(id)));
+        }
+
+        for (auto id : DRAW_STATES) {
+            m_vars[id].registerObserver(
+                std::bind(&ObserverRenderer::switchState, this, _1));
+        }
+
+        for (auto id : DRAW_STATES) {
+            m_vars[id].registerObserver(
+                std::bind(&ObserverRenderer::handler, this, _1, id));
+        }
+    }
+
+    void setState(C3D_ERSID id, C3D_PRSDATA data)
+    {
+        m_vars[id].set(data);
+    }
+
+    uint32_t switches() const
+    {
+        return m_switches;
+    }
+
+private:
+    void switchState(StateVar::Value&)
+    {
+        m_switches++;
+    }
+
+    void handler(StateVar::Value& value, C3D_ERSID id)
+    {
+        m_values[id] = value.uint32;
+    }
+
+    std::vector<ObserverVar> m_vars;
+    uint32_t m_switches = 0;
+    uint32_t m_values[C3D_ERS_NUM] = {};
+};
+
+// The renderer now: changes are detected by State and dispatched through a
+// table of member function pointers, draw states are only marked dirty.
+class TableRenderer
+{
+public:
+    void setState(C3D_ERSID id, C3D_PRSDATA data)
+    {
+        if (static_cast<uint32_t>(id) >= C3D_ERS_NUM) {
+            throw std::out_of_range("Invalid render state");
+        }
+
+        if (m_state.set(id, data)) {
+            StateHandler handler = STATE_HANDLERS[id];
+            if (handler) {
+                (this->*handler)(m_state.get(id), id);
+            }
+        }
+    }
+
+    uint32_t switches() const
+    {
+        return m_switches;
+    }
+
+private:
+    typedef void (TableRenderer::*StateHandler)(const StateVar::Value& value,
+        C3D_ERSID id);
+
+    static std::array<StateHandler, C3D_ERS_NUM> stateHandlers()
+    {
+        std::array<StateHandler, C3D_ERS_NUM> handlers{};
+        for (auto id : DRAW_STATES) {
+            handlers[id] = &TableRenderer::invalidateState;
+        }
+        return handlers;
+    }
+
+    void invalidateState(const StateVar::Value&, C3D_ERSID id)
+    {
+        m_dirtyStates.set(id);
+        m_switches++;
+    }
+
+    static const std::array<StateHandler, C3D_ERS_NUM> STATE_HANDLERS;
+
+    State m_state;
+    std::bitset<C3D_ERS_NUM> m_dirtyStates;
+    uint32_t m_switches = 0;
+};
+
+const std::array<TableRenderer::StateHandler, C3D_ERS_NUM>
+    TableRenderer::STATE_HANDLERS = TableRenderer::stateHandlers();
+
+struct Call
+{
+    C3D_ERSID id;
+    C3D_PRSDATA data;
+};
+
+} // namespace
+
+int main()
+{
+    // each state alternates randomly between two values, so about half of the
+    // writes are redundant, like the per-primitive state setup in games
+    const uint32_t numCalls = 4096;
+    std::vector<StateVar::Value> values(numCalls * 2);
+    std::vector<Call> calls;
+
+    std::mt19937 random(1234);
+    for (uint32_t i = 0; i < numCalls; i++) {
+        auto id = DRAW_STATES[random() % NUM_DRAW_STATES];
+        auto& value = values[i];
+        value = StateVar::Value{0};
+        value.uint32 = random() % 2 + 1;
+        if (id == C3D_ERS_TMAP_SELECT) {
+            value.htx = &values[numCalls + value.uint32];
+        }
+        calls.push_back({id, &value.raw[0]});
+    }
+
+    // the defaults differ, so the changes are compared after a first pass
+    ObserverRenderer before;
+    TableRenderer after;
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        uint32_t switchesBefore = before.switches();
+        uint32_t switchesAfter = after.switches();
+        for (auto& call : calls) {
+            before.setState(call.id, call.data);
+            after.setState(call.id, call.data);
+        }
+        if (pass == 1 && before.switches() - switchesBefore !=
+                             after.switches() - switchesAfter) {
+            std::printf("state changes don't match\n");
+            return 1;
+        }
+    }
+
+    double timeBefore = test::measure(100, [&] {
+        for (auto& call : calls) {
+            before.setState(call.id, call.data);
+        }
+    });
+    double timeAfter = test::measure(100, [&] {
+        for (auto& call : calls) {
+            after.setState(call.id, call.data);
+        }
+    });
+
+    std::printf("%u SetState calls per round\n", numCalls);
+    std::printf("observers: %6.2f ns per call\n", timeBefore / numCalls);
+    std::printf("table:     %6.2f ns per call (%.1fx)\n", timeAfter / numCalls,
+        timeBefore / timeAfter);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+// records a failed check and continues with the test
+#define CHECK(condition)                                                       \
+    do {                                                                       \
+        if (!(condition)) {                                                    \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,       \
+                #condition);                                                   \
+            glrage::test::failures()++;                                        \
+        }                                                                      \
+    } while (0)
+
+namespace glrage {
+namespace test {
+
+// number of failed checks, test executables return a non-zero exit code if
+// any check failed
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+} // namespace test
+} // namespace glrage
\ No newline at end of file
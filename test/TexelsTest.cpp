@@ -0,0 +1,51 @@
+#include "Test.hpp"
+
+#include <ati3dcif/Texels.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace glrage::cif;
+
+namespace {
+
+// The application keeps its texels and may register them again, so the
+// conversion must leave the source alone and give the same result every time.
+// The counts include remainders that aren't a multiple of the eight texels
+// converted at once.
+void testToggleAlpha1555()
+{
+    std::mt19937 random(1);
+
+    const size_t counts[] = {0, 1, 7, 8, 9, 15, 64, 64 * 64 + 5};
+    for (size_t count : counts) {
+        std::vector<uint16_t> src(count);
+        for (auto& texel : src) {
+            texel = static_cast<uint16_t>(random());
+        }
+        std::vector<uint16_t> original = src;
+
+        // one texel more than converted, which must not be touched
+        std::vector<uint16_t> first(count + 1, 0x1234);
+        std::vector<uint16_t> second(count + 1, 0x1234);
+        toggleAlpha1555(src.data(), count, first.data());
+        toggleAlpha1555(src.data(), count, second.data());
+
+        CHECK(first == second);
+        CHECK(src == original);
+        CHECK(first[count] == 0x1234);
+
+        for (size_t i = 0; i < count; i++) {
+            CHECK(first[i] == (src[i] ^ 0x8000));
+        }
+    }
+}
+
+} // namespace
+
+int main()
+{
+    testToggleAlpha1555();
+    return glrage::test::failures() != 0;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "Test.hpp"
+
+#include <ati3dcif/VertexColor.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+using namespace glrage::cif;
+
+namespace {
+
+// The previous vertex format passed the float components to the shader,
+// which divided them by 255. The result was clamped and rounded to the
+// nearest byte when written to the RGBA8 framebuffer.
+uint8_t previousChannel(float value)
+{
+    float clamped = std::fmin(std::fmax(value, 0.0f), 255.0f);
+    return static_cast<uint8_t>(std::floor(clamped + 0.5f));
+}
+
+uint8_t channel(uint32_t rgba, uint32_t index)
+{
+    return static_cast<uint8_t>(rgba >> (index * 8));
+}
+
+// integral colors, the ones applications actually use, are bit-exact
+void testIntegral()
+{
+    for (uint32_t value = 0; value < 256; value++) {
+        float rgba[] = {static_cast<float>(value),
+            static_cast<float>(255 - value), static_cast<float>(value / 2),
+            static_cast<float>(value ^ 0x55)};
+        uint32_t packed = packColor(rgba);
+
+        for (uint32_t i = 0; i < 4; i++) {
+            CHECK(channel(packed, i) == previousChannel(rgba[i]));
+        }
+    }
+}
+
+// colors outside the range are clamped like the framebuffer write did
+void testClamped()
+{
+    float rgba[] = {-1.0f, 256.0f, -100000.0f, 100000.0f};
+    uint32_t packed = packColor(rgba);
+    CHECK(packed == 0xff00ff00);
+}
+
+// Fractions are rounded to the nearest integer during ingestion now, while
+// the previous path only rounded after interpolation. The allowed difference
+// is half a step, which is the most rounding can change. Exact halves round
+// to even instead of up.
+void testFractional()
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> values(0.0f, 255.0f);
+
+    for (uint32_t n = 0; n < 100000; n++) {
+        float rgba[] = {values(random), values(random), values(random),
+            values(random)};
+        uint32_t packed = packColor(rgba);
+
+        for (uint32_t i = 0; i < 4; i++) {
+            CHECK(std::fabs(channel(packed, i) - rgba[i]) <= 0.5f);
+        }
+    }
+
+    float halves[] = {0.5f, 1.5f, 2.5f, 254.5f};
+    CHECK(packColor(halves) == 0xfe020200);
+}
+
+// ARGB colors of TLVERTEX were split into float components before
+void testSwizzle()
+{
+    std::mt19937 random(2);
+
+    for (uint32_t n = 0; n < 100000; n++) {
+        uint32_t argb = random();
+        float rgba[] = {static_cast<float>((argb >> 16) & 0xff),
+            static_cast<float>((argb >> 8) & 0xff),
+            static_cast<float>(argb & 0xff), static_cast<float>(argb >> 24)};
+        CHECK(swizzleColor(argb) == packColor(rgba));
+    }
+}
+
+} // namespace
+
+int main()
+{
+    testIntegral();
+    testClamped();
+    testFractional();
+    testSwizzle();
+    return glrage::test::failures() != 0;
+}
\ No newline at end of file